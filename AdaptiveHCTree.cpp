@@ -0,0 +1,249 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides, Vitter, "Design and Analysis of
+ * Dynamic Huffman Codes" (JACM 1987).
+ *
+ * This file provides the implementation of the adaptive Huffman tree.
+ */
+
+#include "AdaptiveHCTree.hpp"
+#include "Helper.hpp"
+
+#include <algorithm>
+#include <vector>
+
+AdaptiveHCTree::AdaptiveHCTree() : nodeCount(0) {
+    fill(leafOf, leafOf + ADAPTIVE_SYMBOLS, -1);
+
+    // NYT starts out as the root, with the highest number.
+    nyt = root = newNode(0, -1);
+    parent[root] = -1;
+    number[root] = MAX_NODES - 1;
+    order[MAX_NODES - 1] = root;
+
+    startSymbol();
+}
+
+int AdaptiveHCTree::newNode(int nodeWeight, int nodeSymbol) {
+    int node = nodeCount++;
+    weight[node] = nodeWeight;
+    symbol[node] = nodeSymbol;
+    child[node][0] = child[node][1] = -1;
+    return node;
+}
+
+void AdaptiveHCTree::swapNodes(int x, int y) {
+    int px = parent[x];
+    int py = parent[y];
+    int sideX = child[px][1] == x;
+    int sideY = child[py][1] == y;
+
+    // Siblings simply trade sides.
+    child[px][sideX] = y;
+    child[py][sideY] = x;
+    parent[x] = py;
+    parent[y] = px;
+
+    swap(number[x], number[y]);
+    order[number[x]] = x;
+    order[number[y]] = y;
+}
+
+int AdaptiveHCTree::leader(int node) const {
+    int n = number[node];
+    while (n + 1 < MAX_NODES) {
+        int next = order[n + 1];
+        if (weight[next] != weight[node] || isLeaf(next) != isLeaf(node)) {
+            break;
+        }
+        n++;
+    }
+    return order[n];
+}
+
+int AdaptiveHCTree::slideAndIncrement(int node) {
+    int wt = weight[node];
+    bool leaf = isLeaf(node);
+    int oldParent = parent[node];
+
+    // A leaf of weight w+1 belongs after the internal nodes of weight w,
+    // and an internal node of weight w+1 after the leaves of weight w+1.
+    while (number[node] + 1 < MAX_NODES) {
+        int next = order[number[node] + 1];
+        bool passes = leaf ? !isLeaf(next) && weight[next] == wt
+                           : isLeaf(next) && weight[next] == wt + 1;
+        if (!passes) {
+            break;
+        }
+        swapNodes(node, next);
+    }
+    weight[node]++;
+
+    // A leaf carries on with its new parent; an internal node that slid
+    // away still owes its weight to the old one.
+    return leaf ? parent[node] : oldParent;
+}
+
+void AdaptiveHCTree::update(int sym) {
+    int leafToIncrement = -1;
+    int node = leafOf[sym];
+
+    if (node < 0) {
+        // NYT splits into a new NYT and a leaf for the new symbol, below
+        // an internal node that takes its place and number.
+        int n = number[nyt];
+        int zero = newNode(0, -1);
+        int leaf = newNode(0, sym);
+        child[nyt][0] = zero;
+        child[nyt][1] = leaf;
+        parent[zero] = parent[leaf] = nyt;
+        number[leaf] = n - 1;
+        order[n - 1] = leaf;
+        number[zero] = n - 2;
+        order[n - 2] = zero;
+        leafOf[sym] = leaf;
+
+        node = nyt;
+        nyt = zero;
+        leafToIncrement = leaf;
+    } else {
+        swapNodes(node, leader(node));
+
+        // The sibling of NYT would have to slide past its own parent;
+        // increase the parent first.
+        if (parent[node] == parent[nyt]) {
+            leafToIncrement = node;
+            node = parent[node];
+        }
+    }
+
+    while (node >= 0) {
+        node = slideAndIncrement(node);
+    }
+    if (leafToIncrement >= 0) {
+        slideAndIncrement(leafToIncrement);
+    }
+
+    if (weight[root] >= MAX_WEIGHT) {
+        rescale();
+    }
+}
+
+void AdaptiveHCTree::rescale() {
+
+    // Halve the leaf weights (a seen symbol keeps at least 1) and sort the
+    // leaves by weight, then symbol, with NYT first.
+    vector<pair<int, int> > leaves;
+    for (int s = 0; s < ADAPTIVE_SYMBOLS; s++) {
+        if (leafOf[s] >= 0) {
+            leaves.push_back(make_pair((weight[leafOf[s]] + 1) / 2, s));
+        }
+    }
+    sort(leaves.begin(), leaves.end());
+
+    nodeCount = 0;
+    vector<int> leafNodes;
+    leafNodes.push_back(nyt = newNode(0, -1));
+    for (size_t i = 0; i < leaves.size(); i++) {
+        int leaf = newNode(leaves[i].first, leaves[i].second);
+        leafOf[leaves[i].second] = leaf;
+        leafNodes.push_back(leaf);
+    }
+
+    // Huffman's algorithm with two queues: the sorted leaves, and the
+    // internal nodes in the (non-decreasing) order they are made. On a
+    // tie the leaf goes first. Numbering nodes in the order they leave
+    // the queues restores the sibling property.
+    vector<int> internal;
+    size_t nextLeaf = 0;
+    size_t nextInternal = 0;
+    int n = MAX_NODES - (2 * (int)leafNodes.size() - 1);
+    auto take = [&]() {
+        int node;
+        if (nextInternal == internal.size() ||
+            (nextLeaf < leafNodes.size() &&
+             weight[leafNodes[nextLeaf]] <= weight[internal[nextInternal]])) {
+            node = leafNodes[nextLeaf++];
+        } else {
+            node = internal[nextInternal++];
+        }
+        number[node] = n;
+        order[n++] = node;
+        return node;
+    };
+
+    while ((leafNodes.size() - nextLeaf) + (internal.size() - nextInternal)
+           > 1) {
+        int c0 = take();
+        int c1 = take();
+        int node = newNode(weight[c0] + weight[c1], -1);
+        child[node][0] = c0;
+        child[node][1] = c1;
+        parent[c0] = parent[c1] = node;
+        internal.push_back(node);
+    }
+    root = take();
+    parent[root] = -1;
+}
+
+void AdaptiveHCTree::startSymbol() {
+    cursor = root;
+    literalBits = 0;
+
+    // With nothing seen yet, the NYT code is empty.
+    if (isLeaf(root)) {
+        literalBits = LITERAL_BITS;
+        literal = 0;
+    }
+}
+
+void AdaptiveHCTree::encode(int sym, BitWriter & out) {
+    int node = leafOf[sym] >= 0 ? leafOf[sym] : nyt;
+
+    // Collect the path from the leaf up, then write it from the root down.
+    unsigned char path[MAX_NODES];
+    int depth = 0;
+    for (; parent[node] >= 0; node = parent[node]) {
+        path[depth++] = child[parent[node]][1] == node;
+    }
+    while (depth > 0) {
+        out.write_bits(path[--depth], 1);
+    }
+
+    if (leafOf[sym] < 0) {
+        out.write_bits(sym, LITERAL_BITS);
+    }
+    update(sym);
+}
+
+int AdaptiveHCTree::decodeBit(int bit) {
+    if (literalBits == 0) {
+        cursor = child[cursor][bit];
+        if (!isLeaf(cursor)) {
+            return -1;
+        }
+        if (cursor == nyt) {
+            literalBits = LITERAL_BITS;
+            literal = 0;
+            return -1;
+        }
+        int sym = symbol[cursor];
+        update(sym);
+        startSymbol();
+        return sym;
+    }
+
+    literal = literal << 1 | bit;
+    if (--literalBits != 0) {
+        return -1;
+    }
+    if (literal >= ADAPTIVE_SYMBOLS || leafOf[literal] >= 0) {
+        error("Corrupt adaptive stream");
+    }
+    int sym = literal;
+    update(sym);
+    startSymbol();
+    return sym;
+}
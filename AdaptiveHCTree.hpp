@@ -0,0 +1,136 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides, Vitter, "Design and Analysis of
+ * Dynamic Huffman Codes" (JACM 1987).
+ *
+ * This file provides an adaptive Huffman tree (Vitter's algorithm V) for
+ * the headerless streaming format. Encoder and decoder both start from a
+ * tree holding only the NYT ("not yet transmitted") node and update it
+ * the same way after every symbol, so no tree is ever written and the
+ * first bits can go out as soon as the first byte comes in. A symbol seen
+ * for the first time is sent as the code of the NYT node followed by the
+ * symbol in LITERAL_BITS bits. The stream ends with EOF_SYMBOL.
+ *
+ * The tree lives in flat arrays indexed by node id. Every node also has
+ * an implicit number; listed by number, weights never decrease, siblings
+ * are next to each other, and leaves come before internal nodes of the
+ * same weight. When the root weight reaches MAX_WEIGHT, all weights are
+ * halved and the tree is rebuilt deterministically, so old statistics
+ * fade out and counts stay bounded.
+ */
+
+#ifndef ADAPTIVEHCTREE_HPP
+#define ADAPTIVEHCTREE_HPP
+
+#include "BitIO.hpp"
+
+// First four bytes of an adaptive stream (negative as an int).
+const uint32_t ADAPTIVE_MAGIC = 0xADA9F00D;
+
+// The bytes plus the end of stream marker.
+const int ADAPTIVE_SYMBOLS = 257;
+const int EOF_SYMBOL = 256;
+
+// Bits of a literal symbol after the NYT code.
+const int LITERAL_BITS = 9;
+
+/**
+ * An adaptive Huffman Code Tree class
+ */
+class AdaptiveHCTree {
+private:
+    // Leaves for every symbol plus NYT, and the internal nodes above them.
+    static const int MAX_NODES = 2 * (ADAPTIVE_SYMBOLS + 1) - 1;
+
+    // Root weight at which all weights are halved.
+    static const int MAX_WEIGHT = 1 << 16;
+
+    // The nodes, indexed by node id.
+    int weight[MAX_NODES];
+    int parent[MAX_NODES];    // -1 for the root
+    int child[MAX_NODES][2];  // -1 for leaves
+    int symbol[MAX_NODES];    // -1 for NYT and internal nodes
+    int number[MAX_NODES];    // the implicit number of the node
+    int order[MAX_NODES];     // the node with a given number
+
+    int leafOf[ADAPTIVE_SYMBOLS]; // -1 until the symbol has been seen
+    int nodeCount;
+    int root;
+    int nyt;
+
+    // Decoder state: the node reached so far, or the literal being read.
+    int cursor;
+    int literalBits;
+    int literal;
+
+    /**
+     * @return true if node is a leaf (NYT included)
+     */
+    bool isLeaf(int node) const { return child[node][0] < 0; }
+
+    /**
+     * Take a new node from the arrays.
+     */
+    int newNode(int nodeWeight, int nodeSymbol);
+
+    /**
+     * Exchange the places of two nodes (with their subtrees) in the tree,
+     * and their numbers. Neither may be an ancestor of the other.
+     */
+    void swapNodes(int x, int y);
+
+    /**
+     * @return the highest numbered node of the same weight and kind
+     */
+    int leader(int node) const;
+
+    /**
+     * Move node past the block of nodes that must come after it once its
+     * weight grows, and increase its weight.
+     *
+     * @return the next node to increase (-1 after the root)
+     */
+    int slideAndIncrement(int node);
+
+    /**
+     * Update the tree after coding a symbol.
+     */
+    void update(int sym);
+
+    /**
+     * Halve all weights and rebuild the tree from the leaves.
+     */
+    void rescale();
+
+    /**
+     * Get ready to decode the next symbol.
+     */
+    void startSymbol();
+
+public:
+    /**
+     * Constructor, which starts with only the NYT node
+     */
+    AdaptiveHCTree();
+
+    /**
+     * Write the code of a symbol and update the tree.
+     *
+     * @param sym the symbol (a byte or EOF_SYMBOL)
+     * @param out bit writer for the encoded bits
+     */
+    void encode(int sym, BitWriter & out);
+
+    /**
+     * Feed the decoder one bit, updating the tree when a symbol is
+     * complete.
+     *
+     * @param bit the next bit of the stream
+     * @return the decoded symbol, or -1 if more bits are needed
+     */
+    int decodeBit(int bit);
+};
+
+#endif // ADAPTIVEHCTREE_HPP
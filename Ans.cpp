@@ -0,0 +1,219 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the implementation of the tANS coder.
+ */
+
+#include "Ans.hpp"
+#include "BitIO.hpp"
+#include "Helper.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * One state of the decoding table: the symbol it decodes, and how to get
+ * the next state (newState plus the next nbBits bits).
+ */
+struct AnsDecodeEntry {
+    uint16_t newState;
+    unsigned char symbol;
+    unsigned char nbBits;
+};
+
+/**
+ * @return the position of the highest set bit of x (x > 0)
+ */
+static inline int highBit(uint32_t x) {
+    return 31 - __builtin_clz(x);
+}
+
+/**
+ * Scale a histogram so it sums to ANS_TABLE_SIZE, keeping every symbol
+ * that occurs at a count of at least 1.
+ *
+ * @param symFreq how often each byte occurs
+ * @param size the sum of symFreq (> 0)
+ * @param norm set to 256 scaled counts
+ */
+static void normalize(const vector<int>& symFreq, size_t size, int* norm) {
+    int sum = 0;
+    for (int s = 0; s < 256; s++) {
+        norm[s] = 0;
+        if (symFreq[s] != 0) {
+            uint64_t scaled = ((uint64_t)symFreq[s] * ANS_TABLE_SIZE +
+                               size / 2) / size;
+            norm[s] = scaled > 0 ? (int)scaled : 1;
+            sum += norm[s];
+        }
+    }
+
+    // Rounding (and the minimum of 1) leaves the sum a little off. Fix it
+    // one count at a time, each time where it changes the coded size
+    // (count * log2 of the probability) the least.
+    while (sum != ANS_TABLE_SIZE) {
+        int step = sum > ANS_TABLE_SIZE ? -1 : 1;
+        int best = -1;
+        double bestCost = 0;
+        for (int s = 0; s < 256; s++) {
+            if (norm[s] + step < 1 || symFreq[s] == 0) {
+                continue;
+            }
+            double cost = symFreq[s] * log2((double)norm[s] /
+                                            (norm[s] + step));
+            if (best < 0 || cost < bestCost) {
+                best = s;
+                bestCost = cost;
+            }
+        }
+        norm[best] += step;
+        sum += step;
+    }
+}
+
+/**
+ * Lay the symbols out over the table, each norm[s] times, spread apart so
+ * every symbol gets states all over the range.
+ *
+ * @param norm the scaled counts (summing to ANS_TABLE_SIZE)
+ * @param spread set to the symbol of each of the ANS_TABLE_SIZE states
+ */
+static void spreadSymbols(const int* norm, unsigned char* spread) {
+    const int step = (ANS_TABLE_SIZE >> 1) + (ANS_TABLE_SIZE >> 3) + 3;
+    const int mask = ANS_TABLE_SIZE - 1;
+
+    int pos = 0;
+    for (int s = 0; s < 256; s++) {
+        for (int i = 0; i < norm[s]; i++) {
+            spread[pos] = s;
+            pos = (pos + step) & mask;
+        }
+    }
+}
+
+void encodeAns(const unsigned char* data, size_t size,
+               const vector<int>& symFreq, vector<unsigned char>& out) {
+    int norm[256];
+    normalize(symFreq, size, norm);
+
+    unsigned char spread[ANS_TABLE_SIZE];
+    spreadSymbols(norm, spread);
+
+    // The states of symbol s are numbered norm[s]..2*norm[s]-1 in table
+    // order; encodeTable maps them back to their table position (plus
+    // ANS_TABLE_SIZE, the encoder's range of states).
+    int cumul[256];
+    int next[256];
+    int total = 0;
+    for (int s = 0; s < 256; s++) {
+        cumul[s] = total;
+        next[s] = norm[s];
+        total += norm[s];
+    }
+    uint16_t encodeTable[ANS_TABLE_SIZE];
+    for (int u = 0; u < ANS_TABLE_SIZE; u++) {
+        int s = spread[u];
+        encodeTable[cumul[s] + next[s]++ - norm[s]] = ANS_TABLE_SIZE + u;
+    }
+
+    // The bits to flush for a symbol are this many, or one fewer.
+    int maxBits[256];
+    for (int s = 0; s < 256; s++) {
+        maxBits[s] = norm[s] != 0 ? ANS_TABLE_LOG - highBit(norm[s]) : 0;
+    }
+
+    // Run backwards, remembering the bits of every step (value << 4 |
+    // count); each thread reuses its buffer.
+    static thread_local vector<uint16_t> steps;
+    steps.resize(size);
+
+    uint32_t state = ANS_TABLE_SIZE;
+    for (size_t i = size; i-- > 0;) {
+        int s = data[i];
+        int nb = maxBits[s];
+        if ((int)(state >> nb) < norm[s]) {
+            nb--;
+        }
+        steps[i] = (uint16_t)((state & ((1u << nb) - 1)) << 4 | nb);
+        state = encodeTable[cumul[s] + (state >> nb) - norm[s]];
+    }
+
+    // Header: the symbols that occur and their scaled counts.
+    BitWriter bits(out);
+    for (int s = 0; s < 256; s += 8) {
+        unsigned char present = 0;
+        for (int b = 0; b < 8; b++) {
+            if (norm[s + b] != 0) {
+                present |= 1 << b;
+            }
+        }
+        bits.write<unsigned char>(present);
+    }
+    for (int s = 0; s < 256; s++) {
+        if (norm[s] != 0) {
+            bits.write_bits(norm[s] - 1, ANS_TABLE_LOG);
+        }
+    }
+
+    // The decoder reads the steps forwards, starting from the last state.
+    bits.write_bits(state - ANS_TABLE_SIZE, ANS_TABLE_LOG);
+    for (size_t i = 0; i < size; i++) {
+        bits.write_bits(steps[i] >> 4, steps[i] & 0xF);
+    }
+    bits.flush();
+}
+
+void decodeAns(const unsigned char* payload, size_t payloadSize,
+               unsigned char* out, size_t size) {
+    BitReader bits(payload, payloadSize);
+
+    int norm[256];
+    unsigned char present[32];
+    for (int i = 0; i < 32; i++) {
+        present[i] = bits.read<unsigned char>();
+    }
+    int total = 0;
+    for (int s = 0; s < 256; s++) {
+        norm[s] = 0;
+        if (present[s / 8] & (1 << (s % 8))) {
+            norm[s] = (int)bits.read_bits(ANS_TABLE_LOG) + 1;
+            total += norm[s];
+        }
+    }
+    if (!bits.good() || total != ANS_TABLE_SIZE) {
+        error("Corrupt block payload");
+    }
+
+    unsigned char spread[ANS_TABLE_SIZE];
+    spreadSymbols(norm, spread);
+
+    // Build the decoding table; each thread reuses its table.
+    static thread_local vector<AnsDecodeEntry> table(ANS_TABLE_SIZE);
+    int next[256];
+    for (int s = 0; s < 256; s++) {
+        next[s] = norm[s];
+    }
+    for (int u = 0; u < ANS_TABLE_SIZE; u++) {
+        AnsDecodeEntry& entry = table[u];
+        int k = next[spread[u]]++;
+        entry.symbol = spread[u];
+        entry.nbBits = ANS_TABLE_LOG - highBit(k);
+        entry.newState = (k << entry.nbBits) - ANS_TABLE_SIZE;
+    }
+
+    // One lookup and one read per symbol.
+    const AnsDecodeEntry* entries = table.data();
+    uint32_t state = bits.read_bits(ANS_TABLE_LOG);
+    for (size_t i = 0; i < size; i++) {
+        const AnsDecodeEntry& entry = entries[state];
+        out[i] = entry.symbol;
+        state = entry.newState + bits.read_bits(entry.nbBits);
+    }
+
+    if (!bits.good()) {
+        error("Corrupt block payload");
+    }
+}
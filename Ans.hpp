@@ -0,0 +1,57 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides a table-based asymmetric numeral system (tANS)
+ * coder for the block format, as an alternative to Huffman coding. It
+ * starts from the same histogram, scaled so the counts sum to the table
+ * size, and can spend a fraction of a bit on a symbol instead of at least
+ * one, which matters for skewed data. The payload of a METHOD_ANS block
+ * is:
+ *
+ *   which symbols occur (256 bit map, 32 bytes)
+ *   their scaled counts minus one (ANS_TABLE_LOG bits each)
+ *   the initial decoder state (ANS_TABLE_LOG bits)
+ *   bitstream
+ *
+ * The encoder runs backwards over the block, so that the decoder can run
+ * forwards: every symbol is one table lookup plus reading the number of
+ * bits the table entry says.
+ */
+
+#ifndef ANS_HPP
+#define ANS_HPP
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// The decoding table has 2^ANS_TABLE_LOG states.
+const int ANS_TABLE_LOG = 12;
+const int ANS_TABLE_SIZE = 1 << ANS_TABLE_LOG;
+
+/**
+ * Code a block with tANS and append the payload to out.
+ *
+ * @param data the raw bytes
+ * @param size how many bytes (> 0)
+ * @param symFreq how often each byte occurs in data
+ * @param out the output bytes
+ */
+void encodeAns(const unsigned char* data, size_t size,
+               const vector<int>& symFreq, vector<unsigned char>& out);
+
+/**
+ * Decode a tANS payload.
+ *
+ * @param payload the payload bytes
+ * @param payloadSize how many payload bytes
+ * @param out where to store the decoded bytes
+ * @param size how many bytes to decode
+ */
+void decodeAns(const unsigned char* payload, size_t payloadSize,
+               unsigned char* out, size_t size);
+
+#endif // ANS_HPP
@@ -0,0 +1,226 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the implementation of the archive container.
+ */
+
+#include "Archive.hpp"
+#include "BitIO.hpp"
+#include "Helper.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Sizes of the fixed parts of an archive.
+static const size_t ARCHIVE_HEADER_SIZE = 8;
+static const size_t ARCHIVE_TRAILER_SIZE = 12;
+
+// Smallest TOC record (an empty name).
+static const size_t MIN_ENTRY_SIZE = 2 + 3 * 8;
+
+/**
+ * Write all of buf at offset, retrying short writes.
+ */
+static void writeAt(int fd, const string& path, const unsigned char* buf,
+                    size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error("Cannot write " + path + ": " + strerror(errno));
+        }
+        buf += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+/**
+ * Read all of buf from offset, retrying short reads.
+ */
+static void readAt(int fd, const string& path, unsigned char* buf,
+                   size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error("Cannot read " + path);
+        }
+        buf += n;
+        len -= n;
+        offset += n;
+    }
+}
+
+bool safeEntryName(const string& name) {
+    if (name.empty()) {
+        return false;
+    }
+
+    // Look at every component between slashes.
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t slash = name.find('/', start);
+        if (slash == string::npos) {
+            slash = name.size();
+        }
+        string part = name.substr(start, slash - start);
+        if (part.empty() || part == "." || part == "..") {
+            return false;
+        }
+        start = slash + 1;
+    }
+    return true;
+}
+
+ArchiveWriter::ArchiveWriter(const string& path, size_t count)
+    : path(path), end(ARCHIVE_HEADER_SIZE), entries(count) {
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error("Cannot create " + path + ": " + strerror(errno));
+    }
+
+    vector<unsigned char> header;
+    BitWriter bits(header);
+    bits.write<uint32_t>(ARCHIVE_MAGIC);
+    bits.write<unsigned char>(ARCHIVE_VERSION);
+    bits.write<unsigned char>(0);
+    bits.write<uint16_t>(0);
+    writeAt(fd, path, header.data(), header.size(), 0);
+}
+
+ArchiveWriter::~ArchiveWriter() {
+    close(fd);
+}
+
+void ArchiveWriter::add(size_t index, const string& name,
+                        const vector<unsigned char>& data,
+                        uint64_t originalSize) {
+
+    // Only reserving the space is serialized; the entries are written
+    // in parallel.
+    uint64_t offset;
+    {
+        lock_guard<mutex> guard(lock);
+        offset = end;
+        end += data.size();
+        ArchiveEntry& entry = entries[index];
+        entry.name = name;
+        entry.offset = offset;
+        entry.compressedSize = data.size();
+        entry.originalSize = originalSize;
+    }
+    writeAt(fd, path, data.data(), data.size(), offset);
+}
+
+void ArchiveWriter::finish() {
+    lock_guard<mutex> guard(lock);
+
+    vector<unsigned char> toc;
+    BitWriter bits(toc);
+    bits.write<uint32_t>(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        const ArchiveEntry& entry = entries[i];
+        bits.write<uint16_t>(entry.name.size());
+        for (size_t c = 0; c < entry.name.size(); c++) {
+            bits.write<unsigned char>(entry.name[c]);
+        }
+        bits.write<uint64_t>(entry.offset);
+        bits.write<uint64_t>(entry.compressedSize);
+        bits.write<uint64_t>(entry.originalSize);
+    }
+    bits.write<uint64_t>(end);
+    bits.write<uint32_t>(ARCHIVE_MAGIC);
+
+    writeAt(fd, path, toc.data(), toc.size(), end);
+}
+
+ArchiveReader::ArchiveReader(const string& path) : path(path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        (uint64_t)st.st_size < ARCHIVE_HEADER_SIZE + 4 + ARCHIVE_TRAILER_SIZE) {
+        close(fd);
+        error("Not an archive: " + path);
+    }
+    uint64_t fileSize = st.st_size;
+
+    // Check the magic number at both ends.
+    unsigned char fixed[ARCHIVE_TRAILER_SIZE];
+    readAt(fd, path, fixed, ARCHIVE_HEADER_SIZE, 0);
+    BitReader header(fixed, ARCHIVE_HEADER_SIZE);
+    uint32_t magic = header.read<uint32_t>();
+    unsigned char version = header.read<unsigned char>();
+    if (magic != ARCHIVE_MAGIC) {
+        close(fd);
+        error("Not an archive: " + path);
+    }
+    if (version != ARCHIVE_VERSION) {
+        close(fd);
+        error("Unsupported archive version");
+    }
+
+    uint64_t trailerOffset = fileSize - ARCHIVE_TRAILER_SIZE;
+    readAt(fd, path, fixed, ARCHIVE_TRAILER_SIZE, trailerOffset);
+    BitReader trailer(fixed, ARCHIVE_TRAILER_SIZE);
+    uint64_t tocOffset = trailer.read<uint64_t>();
+    if (trailer.read<uint32_t>() != ARCHIVE_MAGIC ||
+        tocOffset < ARCHIVE_HEADER_SIZE || tocOffset + 4 > trailerOffset) {
+        close(fd);
+        error("Corrupt archive trailer");
+    }
+
+    vector<unsigned char> toc(trailerOffset - tocOffset);
+    readAt(fd, path, toc.data(), toc.size(), tocOffset);
+    BitReader bits(toc.data(), toc.size());
+
+    // The count is checked against the TOC size before reserving for it.
+    uint32_t count = bits.read<uint32_t>();
+    if (count > (toc.size() - 4) / MIN_ENTRY_SIZE) {
+        close(fd);
+        error("Corrupt archive TOC");
+    }
+    entries.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        ArchiveEntry& entry = entries[i];
+        uint16_t nameSize = bits.read<uint16_t>();
+        entry.name.resize(nameSize);
+        for (uint16_t c = 0; c < nameSize && bits.good(); c++) {
+            entry.name[c] = bits.read<unsigned char>();
+        }
+        entry.offset = bits.read<uint64_t>();
+        entry.compressedSize = bits.read<uint64_t>();
+        entry.originalSize = bits.read<uint64_t>();
+
+        if (!bits.good() || !safeEntryName(entry.name) ||
+            entry.offset < ARCHIVE_HEADER_SIZE || entry.offset > tocOffset ||
+            entry.compressedSize > tocOffset - entry.offset) {
+            close(fd);
+            error("Corrupt archive TOC");
+        }
+    }
+}
+
+ArchiveReader::~ArchiveReader() {
+    close(fd);
+}
+
+void ArchiveReader::read(const ArchiveEntry& entry,
+                         vector<unsigned char>& out) const {
+    out.resize(entry.compressedSize);
+    readAt(fd, path, out.data(), out.size(), entry.offset);
+}
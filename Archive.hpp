@@ -0,0 +1,134 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the archive container used by batch mode to keep
+ * many compressed files in one output file:
+ *
+ *   header:   magic, version, reserved
+ *   entries:  the compressed files, back to back, in the order they
+ *             finished
+ *   TOC:      count, then for every entry: name length, name, offset,
+ *             compressed size, original size
+ *   trailer:  TOC offset, magic
+ *
+ * Every entry is exactly what compress would have written for that file,
+ * so it can be decompressed on its own. The TOC lists the entries in the
+ * order of the input list, whatever order they were written in.
+ */
+
+#ifndef ARCHIVE_HPP
+#define ARCHIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+// First and last four bytes of an archive.
+const uint32_t ARCHIVE_MAGIC = 0xAC41B10C;
+const unsigned char ARCHIVE_VERSION = 1;
+
+/**
+ * One file in an archive.
+ */
+struct ArchiveEntry {
+    string name;             // relative path of the file
+    uint64_t offset;         // where its compressed bytes start
+    uint64_t compressedSize;
+    uint64_t originalSize;
+};
+
+/**
+ * Check that a name is a safe relative path to extract to.
+ *
+ * @param name the name, with any leading '/' already removed
+ * @return true if it is non-empty and has no "." or ".." component
+ */
+bool safeEntryName(const string& name);
+
+/**
+ * Writes an archive. Entries may be added from several threads at once.
+ */
+class ArchiveWriter {
+private:
+    int fd;
+    string path;
+
+    // Protected by lock.
+    mutex lock;
+    uint64_t end;                 // where the next entry goes
+    vector<ArchiveEntry> entries; // indexed by the entry's list position
+
+public:
+    /**
+     * Constructor, which creates the archive and writes its header
+     *
+     * @param path the archive file
+     * @param count how many entries it will hold
+     */
+    ArchiveWriter(const string& path, size_t count);
+
+    /**
+     * Destructor, which closes the file
+     */
+    ~ArchiveWriter();
+
+    /**
+     * Append an entry. Thread safe.
+     *
+     * @param index the position of the entry in the TOC
+     * @param name the name of the entry
+     * @param data the compressed bytes
+     * @param originalSize the size of the file before compression
+     */
+    void add(size_t index, const string& name,
+             const vector<unsigned char>& data, uint64_t originalSize);
+
+    /**
+     * Write the TOC and the trailer. Call once all entries are added.
+     */
+    void finish();
+};
+
+/**
+ * Reads an archive.
+ */
+class ArchiveReader {
+private:
+    int fd;
+    string path;
+    vector<ArchiveEntry> entries;
+
+public:
+    /**
+     * Constructor, which opens the archive and reads its TOC
+     *
+     * @param path the archive file
+     */
+    explicit ArchiveReader(const string& path);
+
+    /**
+     * Destructor, which closes the file
+     */
+    ~ArchiveReader();
+
+    /**
+     * @return the entries, in TOC order
+     */
+    const vector<ArchiveEntry>& list() const { return entries; }
+
+    /**
+     * Read the compressed bytes of an entry. Thread safe.
+     *
+     * @param entry the entry
+     * @param out set to its compressed bytes (its memory is reused)
+     */
+    void read(const ArchiveEntry& entry, vector<unsigned char>& out) const;
+};
+
+#endif // ARCHIVE_HPP
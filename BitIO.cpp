@@ -0,0 +1,65 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the non-inline implementations for BitWriter and
+ * BitReader. Note: the template functions are implemented in BitIO.tcc.
+ */
+
+#include "BitIO.hpp"
+#include <algorithm>
+
+void BitWriter::write_bit(char const& bit) {
+    // crash if invalid input
+    if (bit != 0 && bit != 1) {
+        error("Trying to write invalid bit");
+    }
+    write_bits(bit, 1);
+}
+
+void BitWriter::flush() {
+    // if we have bits pending, pad them with zeros to make a full byte
+    if (nbits != 0) {
+        write_bits(0, 8 - nbits);
+    }
+}
+
+void BitReader::readBytes(unsigned char* dst, size_t size) {
+    if (consumed % 8 != 0) {
+        error("Attempt to read when bitwise buffer is not empty");
+    }
+
+    // First hand out the real bytes already loaded into the accumulator.
+    uint64_t buffered = loaded - consumed / 8;
+    while (size > 0 && buffered > 0) {
+        *dst++ = (unsigned char)peek(8);
+        skip(8);
+        size--;
+        buffered--;
+    }
+    acc = 0;
+    nbits = 0;
+
+    // Then copy straight from the buffers.
+    while (size > 0) {
+        if (cur == end) {
+            if (source == nullptr || !source->next(cur, end)) {
+                // Out of input: zero fill, and good() turns false.
+                source = nullptr;
+                memset(dst, 0, size);
+                consumed += 8 * (uint64_t)size;
+                return;
+            }
+            continue;
+        }
+        size_t chunk = min(size, (size_t)(end - cur));
+        memcpy(dst, cur, chunk);
+        cur += chunk;
+        dst += chunk;
+        size -= chunk;
+        loaded += chunk;
+        consumed += 8 * (uint64_t)chunk;
+    }
+}
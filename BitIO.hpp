@@ -0,0 +1,250 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides in-memory bit writers and readers. They mirror the
+ * write_bit/read_bit/write<T>/read<T> interface of FancyOutputStream and
+ * FancyInputStream (same MSB-first bit order, so the bytes produced are
+ * identical), but work on memory buffers with a 64-bit accumulator so that
+ * a whole codeword can be written or peeked at once.
+ */
+
+#ifndef BITIO_HPP
+#define BITIO_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Helper.hpp"
+using namespace std;
+
+/**
+ * Supplies the next buffer of bytes to a BitReader once the current one
+ * has been consumed (e.g. the next input block of a BlockPipeline).
+ */
+class BitSource {
+public:
+    virtual ~BitSource() {}
+
+    /**
+     * Get the next buffer of bytes.
+     *
+     * @param begin set to the start of the next buffer
+     * @param end set to one past the end of the next buffer
+     * @return false if there are no more bytes
+     */
+    virtual bool next(const unsigned char*& begin,
+                      const unsigned char*& end) = 0;
+};
+
+/**
+ * Writes bits (MSB first) to a byte vector.
+ */
+class BitWriter {
+private:
+    vector<unsigned char>* out; // vector the completed bytes are appended to
+    uint64_t acc;               // pending bits (the low nbits bits)
+    int nbits;                  // number of pending bits, always < 8 between calls
+
+public:
+    /**
+     * Constructor, which appends all bytes written to the given vector
+     *
+     * @param out the output byte vector
+     */
+    explicit BitWriter(vector<unsigned char>& out)
+        : out(&out), acc(0), nbits(0) {}
+
+    /**
+     * Redirect the output to another vector. Pending bits are kept, so a
+     * bitstream can be split across several output buffers.
+     *
+     * @param newOut the new output byte vector
+     */
+    void setOutput(vector<unsigned char>& newOut) { out = &newOut; }
+
+    /**
+     * Write the lowest length bits of code, MSB first.
+     *
+     * @param code the bits to write
+     * @param length how many bits to write (at most 56)
+     */
+    void write_bits(uint64_t code, int length) {
+        acc = (acc << length) | code;
+        nbits += length;
+        while (nbits >= 8) {
+            nbits -= 8;
+            out->push_back((unsigned char)(acc >> nbits));
+        }
+    }
+
+    /**
+     * Write a single bit
+     *
+     * @param bit a single bit, 1 or 0.
+     */
+    void write_bit(char const& bit);
+
+    /**
+     * Write a generic data type (raw bytes, host byte order).
+     *
+     * @tparam T type, can be int(4 bytes), short(2 bytes), or char(1 byte)
+     * @param data data to be written
+     */
+    template<typename T> void write(const T& data);
+
+    /**
+     * Pad the pending bits with zeros up to the next byte boundary.
+     */
+    void flush();
+
+    /**
+     * @return how many bits are pending (not yet a whole byte)
+     */
+    int pending() const { return nbits; }
+};
+
+/**
+ * Reads bits (MSB first) from memory, optionally pulling further buffers
+ * from a BitSource. Reading past the end of the data yields 0 bits and
+ * makes good() return false.
+ */
+class BitReader {
+private:
+    const unsigned char* cur; // next byte to load into the accumulator
+    const unsigned char* end; // end of the current buffer
+    BitSource* source;        // where to get more bytes (may be null)
+    uint64_t acc;             // loaded bits, left aligned
+    int nbits;                // number of loaded bits
+    uint64_t loaded;          // total real bytes loaded into acc
+    uint64_t consumed;        // total bits consumed
+
+public:
+    /**
+     * Constructor, which reads from the given buffer and then from source
+     *
+     * @param data start of the first buffer
+     * @param size size of the first buffer in bytes
+     * @param source where to get more bytes once data is used up
+     */
+    BitReader(const unsigned char* data, size_t size,
+              BitSource* source = nullptr)
+        : cur(data), end(data + size), source(source), acc(0), nbits(0),
+          loaded(0), consumed(0) {}
+
+    /**
+     * Load bytes until at least 57 bits are available (or the input ends).
+     */
+    void refill() {
+        while (nbits <= 56) {
+            if (cur == end) {
+                if (source == nullptr || !source->next(cur, end)) {
+                    // Out of input: pretend the rest is zero bits.
+                    source = nullptr;
+                    nbits = 64;
+                    return;
+                }
+                continue;
+            }
+            acc |= (uint64_t)*cur++ << (56 - nbits);
+            nbits += 8;
+            loaded++;
+        }
+    }
+
+    /**
+     * Look at the next n bits without consuming them.
+     *
+     * @param n how many bits (1 to 56)
+     * @return the bits, the first one as the MSB of the result
+     */
+    uint64_t peek(int n) {
+        if (nbits < n) {
+            refill();
+        }
+        return acc >> (64 - n);
+    }
+
+    /**
+     * Consume n bits that have already been peeked.
+     *
+     * @param n how many bits
+     */
+    void skip(int n) {
+        acc = n < 64 ? acc << n : 0;
+        nbits -= n;
+        consumed += n;
+    }
+
+    /**
+     * Read the next n bits, where n may also be 0.
+     *
+     * @param n how many bits (0 to 56)
+     * @return the bits, the first one as the MSB of the result
+     */
+    uint64_t read_bits(int n) {
+        if (nbits < n) {
+            refill();
+        }
+        // Shifting in two steps keeps n == 0 defined (and 0).
+        uint64_t bits = (acc >> 1) >> (63 - n);
+        skip(n);
+        return bits;
+    }
+
+    /**
+     * Read a single bit
+     *
+     * @return a single bit, 1 or 0.
+     */
+    char read_bit() {
+        char bit = (char)peek(1);
+        skip(1);
+        return bit;
+    }
+
+    /**
+     * Read a generic data type (raw bytes, host byte order). The reader
+     * must be at a byte boundary.
+     *
+     * @tparam T type, can be int(4 bytes), short(2 bytes), or char(1 byte)
+     * @return data of type T
+     */
+    template<typename T> T read();
+
+    /**
+     * Copy the next size bytes to dst, bypassing the accumulator for bulk
+     * data. The reader must be at a byte boundary.
+     *
+     * @param dst where to copy the bytes to
+     * @param size how many bytes
+     */
+    void readBytes(unsigned char* dst, size_t size);
+
+    /**
+     * Skip the remaining bits of the current byte.
+     */
+    void align() {
+        if (consumed % 8 != 0) {
+            int pad = 8 - consumed % 8;
+            peek(pad);
+            skip(pad);
+        }
+    }
+
+    /**
+     * @return false once more bits were consumed than the input contains
+     */
+    bool good() const { return consumed <= loaded * 8; }
+
+    /**
+     * @return the number of bits consumed so far
+     */
+    uint64_t position() const { return consumed; }
+};
+
+#include "BitIO.tcc"
+
+#endif // BITIO_HPP
@@ -0,0 +1,34 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the template implementations for read and write in
+ * BitReader/BitWriter.
+ */
+
+
+template<typename T>
+void BitWriter::write(const T &data) {
+    if (nbits != 0) {
+        error("Attempting to write byte when bitwise buffer is not empty");
+    }
+    const unsigned char* bytes = (const unsigned char*)&data;
+    out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+T BitReader::read() {
+    if (consumed % 8 != 0) {
+        error("Attempt to read when bitwise buffer is not empty");
+    }
+    unsigned char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bytes[i] = (unsigned char)peek(8);
+        skip(8);
+    }
+    T num;
+    memcpy(&num, bytes, sizeof(T));
+    return num;
+}
@@ -0,0 +1,341 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides the implementation of the block format: writing and
+ * checking the headers, and coding/decoding a single block.
+ */
+
+#include "BlockFormat.hpp"
+#include "Ans.hpp"
+#include "Checksum.hpp"
+#include "HCTree.hpp"
+#include "Order1.hpp"
+#include "TreeCache.hpp"
+#include "Wide.hpp"
+
+#include <cstring>
+
+// A tree over 256 symbols has at most 511 nodes; deserialization gives up
+// beyond that instead of recursing through a corrupt payload.
+static const int MAX_TREE_NODES = 511;
+
+// Flags this version understands.
+static const unsigned char KNOWN_FLAGS = FLAG_CHECKSUM | FLAG_INDEX;
+
+// Size of the trailer of an indexed file, and of one index entry.
+static const size_t INDEX_TRAILER_SIZE = 12;
+static const size_t INDEX_ENTRY_SIZE = 16;
+
+HCTree& threadTree() {
+    static thread_local HCTree tree;
+    return tree;
+}
+
+/**
+ * @param header the file header
+ * @return the size of a block header in this file
+ */
+static size_t blockHeaderSize(const FileHeader& header) {
+    return (header.flags & FLAG_CHECKSUM) ? 16 : 12;
+}
+
+/**
+ * Append a block header to out.
+ */
+static void writeBlockHeader(const FileHeader& header,
+                             const BlockHeader& block,
+                             vector<unsigned char>& out) {
+    BitWriter bits(out);
+    bits.write<unsigned char>(block.method);
+    bits.write<unsigned char>(block.transform);
+    bits.write<uint16_t>(0);
+    bits.write<uint32_t>(block.rawSize);
+    bits.write<uint32_t>(block.payloadSize);
+    if (header.flags & FLAG_CHECKSUM) {
+        bits.write<uint32_t>(block.checksum);
+    }
+}
+
+void writeFileHeader(const FileHeader& header, vector<unsigned char>& out) {
+    BitWriter bits(out);
+    bits.write<uint32_t>(BLOCK_MAGIC);
+    bits.write<unsigned char>(header.version);
+    bits.write<unsigned char>(header.flags);
+    bits.write<uint16_t>(0);
+    bits.write<uint32_t>(header.blockSize);
+    bits.write<uint64_t>(header.totalSize);
+}
+
+FileHeader readFileHeader(BitReader& in) {
+    FileHeader header;
+    header.version = in.read<unsigned char>();
+    header.flags = in.read<unsigned char>();
+    in.read<uint16_t>();
+    header.blockSize = in.read<uint32_t>();
+    header.totalSize = in.read<uint64_t>();
+
+    if (!in.good()) {
+        error("Truncated file header");
+    }
+    if (header.version != BLOCK_VERSION) {
+        error("Unsupported block format version");
+    }
+    if ((header.flags & ~KNOWN_FLAGS) != 0) {
+        error("Unsupported block format flags");
+    }
+    if (header.blockSize == 0 || header.blockSize > MAX_BLOCK_SIZE) {
+        error("Corrupt file header");
+    }
+    return header;
+}
+
+void encodeBlock(const unsigned char* data, size_t size,
+                 const FileHeader& header, vector<unsigned char>& out,
+                 const EncodeOptions& options) {
+    BlockHeader block;
+    block.method = METHOD_HUFFMAN;
+    block.rawSize = size;
+    block.checksum = 0;
+
+    // Checksum the raw bytes while they are hot in the cache.
+    if (header.flags & FLAG_CHECKSUM) {
+        block.checksum = crc32c(data, size);
+    }
+
+    // Transform the bytes first; everything below codes the result.
+    const unsigned char* raw = data;
+    block.transform = options.transform;
+    if (options.transform == TRANSFORM_AUTO) {
+        block.transform = chooseTransform(data, size, options.order1);
+    }
+    if (block.transform != TRANSFORM_NONE) {
+        static thread_local vector<unsigned char> transformed;
+        transformed.resize(size);
+        applyTransform(block.transform, data, size, transformed.data());
+        data = transformed.data();
+    }
+
+    // Leave room for the header, and code the payload right behind it.
+    size_t start = out.size();
+    size_t headerSize = blockHeaderSize(header);
+    out.resize(start + headerSize);
+
+    // Both coders start from the same histogram.
+    vector<int> symFreq(256);
+    for (size_t i = 0; i < size; i++) {
+        symFreq[data[i]]++;
+    }
+
+    if (options.coder == CODER_ANS) {
+        encodeAns(data, size, symFreq, out);
+        block.method = METHOD_ANS;
+    } else if (options.order1 && encodeOrder1(data, size, out)) {
+        block.method = METHOD_ORDER1;
+    } else if (options.trees != nullptr) {
+        shared_ptr<HCTree> tree = options.trees->treeFor(symFreq, size);
+        size_t payloadStart = out.size();
+
+        BitWriter bits(out);
+        tree->serialize(bits);
+        tree->encodeBlock(data, size, bits);
+        bits.flush();
+
+        // The tree may have been built for another block; the count in
+        // front of it has to be the size of this one.
+        int count = size;
+        memcpy(&out[payloadStart], &count, sizeof(count));
+    } else {
+        HCTree& tree = threadTree();
+        tree.build(symFreq);
+
+        BitWriter bits(out);
+        tree.serialize(bits);
+        tree.encodeBlock(data, size, bits);
+        bits.flush();
+    }
+
+    // In auto mode, code the block again with tANS and keep the smaller.
+    static thread_local vector<unsigned char> alternative;
+    if (options.coder == CODER_AUTO) {
+        alternative.clear();
+        encodeAns(data, size, symFreq, alternative);
+        if (alternative.size() < out.size() - start - headerSize) {
+            out.resize(start + headerSize);
+            out.insert(out.end(), alternative.begin(), alternative.end());
+            block.method = METHOD_ANS;
+        }
+    }
+
+    // Likewise with 16-bit symbols in wide mode.
+    if (options.wide) {
+        alternative.clear();
+        encodeWide(data, size, alternative);
+        if (alternative.size() < out.size() - start - headerSize) {
+            out.resize(start + headerSize);
+            out.insert(out.end(), alternative.begin(), alternative.end());
+            block.method = METHOD_WIDE;
+        }
+    }
+
+    // Store the block as is if coding did not make it smaller.
+    block.payloadSize = out.size() - start - headerSize;
+    if (block.payloadSize >= size) {
+        out.resize(start + headerSize);
+        out.insert(out.end(), raw, raw + size);
+        block.method = METHOD_STORED;
+        block.transform = TRANSFORM_NONE;
+        block.payloadSize = size;
+    }
+
+    // Now that the payload size is known, fill in the header.
+    vector<unsigned char> headerBytes;
+    writeBlockHeader(header, block, headerBytes);
+    memcpy(&out[start], headerBytes.data(), headerSize);
+}
+
+void writeEndBlock(const FileHeader& header, vector<unsigned char>& out) {
+    BlockHeader block = {METHOD_END, TRANSFORM_NONE, 0, 0, 0};
+    writeBlockHeader(header, block, out);
+}
+
+void writeBlockIndex(const vector<BlockIndexEntry>& index,
+                     uint64_t indexOffset, vector<unsigned char>& out) {
+    BitWriter bits(out);
+    bits.write<uint32_t>(index.size());
+    for (const BlockIndexEntry& entry : index) {
+        bits.write<uint64_t>(entry.offset);
+        bits.write<uint64_t>(entry.rawOffset);
+    }
+    bits.write<uint64_t>(indexOffset);
+    bits.write<uint32_t>(BLOCK_MAGIC);
+}
+
+uint64_t readBlockIndex(const unsigned char* data, size_t size,
+                        const FileHeader& header,
+                        vector<BlockIndexEntry>& index) {
+    if (size < FILE_HEADER_SIZE + 4 + INDEX_TRAILER_SIZE ||
+        header.totalSize == UNKNOWN_SIZE) {
+        error("Corrupt block index");
+    }
+    uint64_t trailerOffset = size - INDEX_TRAILER_SIZE;
+    BitReader trailer(data + trailerOffset, INDEX_TRAILER_SIZE);
+    uint64_t indexOffset = trailer.read<uint64_t>();
+    if (trailer.read<uint32_t>() != BLOCK_MAGIC ||
+        indexOffset < FILE_HEADER_SIZE || indexOffset + 4 > trailerOffset) {
+        error("Corrupt block index");
+    }
+
+    // The count is checked against the index size before reserving for it.
+    BitReader bits(data + indexOffset, trailerOffset - indexOffset);
+    uint32_t count = bits.read<uint32_t>();
+    if (count != (trailerOffset - indexOffset - 4) / INDEX_ENTRY_SIZE) {
+        error("Corrupt block index");
+    }
+
+    // Blocks are back to back in both the file and the output.
+    index.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        index[i].offset = bits.read<uint64_t>();
+        index[i].rawOffset = bits.read<uint64_t>();
+        if (index[i].offset < FILE_HEADER_SIZE ||
+            index[i].offset >= indexOffset ||
+            index[i].rawOffset >= header.totalSize ||
+            (i > 0 && (index[i].offset <= index[i - 1].offset ||
+                       index[i].rawOffset <= index[i - 1].rawOffset))) {
+            error("Corrupt block index");
+        }
+    }
+    if ((count == 0) != (header.totalSize == 0) ||
+        (count > 0 && index[0].rawOffset != 0)) {
+        error("Corrupt block index");
+    }
+    return indexOffset;
+}
+
+bool readBlockHeader(BitReader& in, const FileHeader& header,
+                     BlockHeader& block) {
+    block.method = in.read<unsigned char>();
+    block.transform = in.read<unsigned char>();
+    in.read<uint16_t>();
+    block.rawSize = in.read<uint32_t>();
+    block.payloadSize = in.read<uint32_t>();
+    block.checksum = 0;
+    if (header.flags & FLAG_CHECKSUM) {
+        block.checksum = in.read<uint32_t>();
+    }
+
+    if (!in.good()) {
+        error("Truncated block header");
+    }
+    if (block.method == METHOD_END) {
+        return false;
+    }
+
+    // Sizes are checked before anything is allocated for them: a coded
+    // block is never bigger than the raw block.
+    if (block.method != METHOD_HUFFMAN && block.method != METHOD_STORED &&
+        block.method != METHOD_ORDER1 && block.method != METHOD_ANS &&
+        block.method != METHOD_WIDE) {
+        error("Corrupt block header");
+    }
+    if (block.transform >= TRANSFORM_COUNT) {
+        error("Corrupt block header");
+    }
+    if (block.rawSize == 0 || block.rawSize > header.blockSize ||
+        block.payloadSize > block.rawSize) {
+        error("Corrupt block header");
+    }
+    return true;
+}
+
+void decodeBlock(const FileHeader& header, const BlockHeader& block,
+                 const unsigned char* payload, unsigned char* out) {
+
+    // A transformed block is decoded to a scratch buffer first, and the
+    // transform undone from there into out.
+    unsigned char* raw = out;
+    if (block.transform != TRANSFORM_NONE) {
+        static thread_local vector<unsigned char> transformed;
+        transformed.resize(block.rawSize);
+        out = transformed.data();
+    }
+
+    if (block.method == METHOD_STORED) {
+        memcpy(out, payload, block.rawSize);
+    } else if (block.method == METHOD_ORDER1) {
+        decodeOrder1(payload, block.payloadSize, out, block.rawSize);
+    } else if (block.method == METHOD_ANS) {
+        decodeAns(payload, block.payloadSize, out, block.rawSize);
+    } else if (block.method == METHOD_WIDE) {
+        decodeWide(payload, block.payloadSize, out, block.rawSize);
+    } else {
+        // The reader is bounded by the payload, so a corrupt block can
+        // not make the decoder run into the next one.
+        BitReader bits(payload, block.payloadSize);
+
+        int count = bits.read<int>();
+        if ((uint32_t)count != block.rawSize) {
+            error("Corrupt block payload");
+        }
+
+        HCTree& tree = threadTree();
+        tree.deserialize(MAX_TREE_NODES, bits);
+        tree.decodeBlock(bits, out, block.rawSize);
+
+        if (!bits.good()) {
+            error("Corrupt block payload");
+        }
+    }
+
+    if (block.transform != TRANSFORM_NONE) {
+        invertTransform(block.transform, out, block.rawSize, raw);
+    }
+
+    if ((header.flags & FLAG_CHECKSUM) &&
+        crc32c(raw, block.rawSize) != block.checksum) {
+        error("Checksum mismatch");
+    }
+}
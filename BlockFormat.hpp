@@ -0,0 +1,224 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides the block format. Instead of one tree and one
+ * bitstream for the whole file, the input is cut into blocks that are
+ * coded independently, each with its own small header:
+ *
+ *   file header:  magic, version, flags, block size, total size
+ *   block header: method, transform, raw size, payload size[, CRC32C]
+ *   payload:      for METHOD_HUFFMAN, exactly what the single-stream
+ *                 format would contain for this block (count, tree,
+ *                 bitstream); for METHOD_STORED, the raw bytes; for
+ *                 METHOD_ORDER1, context-clustered trees and a bitstream
+ *                 (see Order1.hpp); for METHOD_ANS, scaled counts and a
+ *                 tANS bitstream (see Ans.hpp); for METHOD_WIDE, a
+ *                 sparse 16-bit alphabet and a bitstream (see Wide.hpp)
+ *   ...
+ *   end block:    a block header with METHOD_END
+ *   index:        (FLAG_INDEX only) count, then for every block: offset
+ *                 of its block header, offset of its raw bytes
+ *   trailer:      (FLAG_INDEX only) index offset, magic
+ *
+ * Sequential decoders stop at the end block; the index lets a reader of a
+ * whole file find every block without walking the ones before it, e.g.
+ * to decode them all at once.
+ *
+ * Before a block is coded its bytes may go through a reversible transform
+ * (see Transform.hpp); the decoder undoes it after decoding the payload.
+ *
+ * The magic number is negative as an int, so decompress can tell a block
+ * file from a single-stream file (which starts with a positive count).
+ */
+
+#ifndef BLOCKFORMAT_HPP
+#define BLOCKFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "BitIO.hpp"
+#include "Transform.hpp"
+using namespace std;
+
+class HCTree;
+class TreeCache;
+
+// First four bytes of a block format file.
+const uint32_t BLOCK_MAGIC = 0xB10CC0DE;
+const unsigned char BLOCK_VERSION = 1;
+
+// File header flags.
+const unsigned char FLAG_CHECKSUM = 1; // every block carries a CRC32C
+const unsigned char FLAG_INDEX = 2;    // a block index ends the file
+
+// Total size of an input whose size was not known (e.g. a pipe).
+const uint64_t UNKNOWN_SIZE = ~(uint64_t)0;
+
+// Size of the file header, including the magic number.
+const size_t FILE_HEADER_SIZE = 20;
+
+// Largest block size a file may declare.
+const uint32_t MAX_BLOCK_SIZE = 1 << 30;
+
+/**
+ * How a block is coded.
+ */
+enum BlockMethod {
+    METHOD_END = 0,     // no more blocks
+    METHOD_HUFFMAN = 1, // Huffman tree + bitstream
+    METHOD_STORED = 2,  // raw bytes (when coding would not save space)
+    METHOD_ORDER1 = 3,  // one tree per cluster of previous-byte contexts
+    METHOD_ANS = 4,     // table-based ANS instead of Huffman
+    METHOD_WIDE = 5     // Huffman over 16-bit symbols
+};
+
+/**
+ * Which entropy coder the encoder uses.
+ */
+enum EntropyCoder {
+    CODER_HUFFMAN, // Huffman (order-0, or order-1 if asked for)
+    CODER_ANS,     // tANS
+    CODER_AUTO     // try both on every block and keep the smaller
+};
+
+/**
+ * Choices the encoder makes per block. They are not part of the file
+ * header: every block header records how the block was coded.
+ */
+struct EncodeOptions {
+    bool order1;        // try order-1 context trees before a single tree
+    bool wide;          // also try 16-bit symbols, and keep the smaller
+    EntropyCoder coder;
+    int transform;      // a Transform, or TRANSFORM_AUTO to pick per block
+    TreeCache* trees;   // where to get Huffman trees, or nullptr to build
+
+    EncodeOptions()
+        : order1(false), wide(false), coder(CODER_HUFFMAN),
+          transform(TRANSFORM_NONE), trees(nullptr) {}
+};
+
+/**
+ * The file header.
+ */
+struct FileHeader {
+    unsigned char version;
+    unsigned char flags;
+    uint32_t blockSize;  // largest raw size of a block
+    uint64_t totalSize;  // total raw size, or UNKNOWN_SIZE
+};
+
+/**
+ * The header in front of every block.
+ */
+struct BlockHeader {
+    unsigned char method;
+    unsigned char transform; // applied to the raw bytes before coding
+    uint32_t rawSize;     // size of the block once decoded
+    uint32_t payloadSize; // size of the coded block that follows
+    uint32_t checksum;    // CRC32C of the raw block (if FLAG_CHECKSUM)
+};
+
+/**
+ * Where a block is, in an indexed file.
+ */
+struct BlockIndexEntry {
+    uint64_t offset;    // offset of the block header in the file
+    uint64_t rawOffset; // offset of the decoded block in the output
+};
+
+/**
+ * Each thread keeps one tree (with its node pool and code tables) and
+ * reuses it for every block or buffer it codes or decodes.
+ *
+ * @return this thread's tree
+ */
+HCTree& threadTree();
+
+/**
+ * Append the file header (including the magic number) to out.
+ *
+ * @param header the file header
+ * @param out the output bytes
+ */
+void writeFileHeader(const FileHeader& header, vector<unsigned char>& out);
+
+/**
+ * Read the rest of the file header after the magic number.
+ *
+ * @param in the input bits, positioned just after the magic number
+ * @return the file header
+ */
+FileHeader readFileHeader(BitReader& in);
+
+/**
+ * Code a block of raw bytes and append its header and payload to out.
+ *
+ * @param data the raw bytes
+ * @param size how many bytes (at most the file's block size, > 0)
+ * @param header the file header (for the flags)
+ * @param out the output bytes
+ * @param options how to code the block
+ */
+void encodeBlock(const unsigned char* data, size_t size,
+                 const FileHeader& header, vector<unsigned char>& out,
+                 const EncodeOptions& options = EncodeOptions());
+
+/**
+ * Append the end-of-file block to out.
+ *
+ * @param header the file header (for the flags)
+ * @param out the output bytes
+ */
+void writeEndBlock(const FileHeader& header, vector<unsigned char>& out);
+
+/**
+ * Append the block index and the trailer to out (after the end block).
+ *
+ * @param index every block of the file, in order
+ * @param indexOffset the offset in the file the index will be at
+ * @param out the output bytes
+ */
+void writeBlockIndex(const vector<BlockIndexEntry>& index,
+                     uint64_t indexOffset, vector<unsigned char>& out);
+
+/**
+ * Read and check the block index of a whole file in memory.
+ *
+ * @param data the whole file
+ * @param size its size
+ * @param header its file header (with FLAG_INDEX and a known total size)
+ * @param index set to every block of the file, in order
+ * @return the offset of the index, which ends the last block
+ */
+uint64_t readBlockIndex(const unsigned char* data, size_t size,
+                        const FileHeader& header,
+                        vector<BlockIndexEntry>& index);
+
+/**
+ * Read and check the next block header.
+ *
+ * @param in the input bits, positioned at a block header
+ * @param header the file header
+ * @param block set to the block header
+ * @return false at the end block
+ */
+bool readBlockHeader(BitReader& in, const FileHeader& header,
+                     BlockHeader& block);
+
+/**
+ * Decode the payload of a block, and verify its checksum if the file has
+ * them.
+ *
+ * @param header the file header
+ * @param block the block header
+ * @param payload the payload bytes (block.payloadSize of them)
+ * @param out where to store the block.rawSize decoded bytes
+ */
+void decodeBlock(const FileHeader& header, const BlockHeader& block,
+                 const unsigned char* payload, unsigned char* out);
+
+#endif // BLOCKFORMAT_HPP
@@ -0,0 +1,165 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Intel SSE4.2 CRC32 instruction reference, RFC 3720
+ *               (CRC32C / Castagnoli polynomial).
+ *
+ * This file provides the implementation of the CRC32C checksum.
+ */
+
+#include "Checksum.hpp"
+
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define HAVE_SSE42_CRC 1
+#endif
+
+// Reflected Castagnoli polynomial.
+static const uint32_t CRC32C_POLY = 0x82F63B78;
+
+/**
+ * Build the byte-at-a-time lookup table for the software fallback.
+ */
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+static const Crc32cTable table;
+
+/**
+ * Software CRC32C on an already inverted crc.
+ */
+static uint32_t crc32cSoftware(uint32_t crc, const unsigned char* data,
+                               size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef HAVE_SSE42_CRC
+// Bytes per lane in the three-way interleaved loop.
+static const size_t LANE_BYTES = 4096;
+
+/**
+ * Lookup tables that advance a crc over LANE_BYTES zero bytes (i.e. the
+ * crc of some data, as if LANE_BYTES more bytes followed it), one table
+ * per byte of the crc. Advancing is linear over GF(2), so it is enough to
+ * advance the 32 single-bit crcs and combine them.
+ */
+struct Crc32cShift {
+    uint32_t entries[4][256];
+
+    Crc32cShift() {
+        vector<unsigned char> zeros(LANE_BYTES, 0);
+        uint32_t basis[32];
+        for (int bit = 0; bit < 32; bit++) {
+            basis[bit] = crc32cSoftware(1u << bit, zeros.data(), LANE_BYTES);
+        }
+        for (int byte = 0; byte < 4; byte++) {
+            for (uint32_t v = 0; v < 256; v++) {
+                uint32_t crc = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    if (v & (1u << bit)) {
+                        crc ^= basis[8 * byte + bit];
+                    }
+                }
+                entries[byte][v] = crc;
+            }
+        }
+    }
+
+    uint32_t operator()(uint32_t crc) const {
+        return entries[0][crc & 0xFF] ^ entries[1][(crc >> 8) & 0xFF] ^
+               entries[2][(crc >> 16) & 0xFF] ^ entries[3][crc >> 24];
+    }
+};
+
+static const Crc32cShift shiftLane;
+
+/**
+ * SSE4.2 CRC32C on an already inverted crc, 8 bytes per instruction.
+ * The crc32 instruction takes 3 cycles but a new one can start every
+ * cycle, so large buffers are run as three independent lanes that are
+ * combined at the end of each round.
+ * Only called after checking that the CPU supports SSE4.2.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(uint32_t crc, const unsigned char* data,
+                            size_t size) {
+#ifdef __x86_64__
+    uint64_t wide = crc;
+    while (size >= 3 * LANE_BYTES) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        for (size_t i = 0; i < LANE_BYTES; i += 8) {
+            uint64_t word0, word1, word2;
+            memcpy(&word0, data + i, sizeof(word0));
+            memcpy(&word1, data + LANE_BYTES + i, sizeof(word1));
+            memcpy(&word2, data + 2 * LANE_BYTES + i, sizeof(word2));
+            wide = _mm_crc32_u64(wide, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+        wide = shiftLane(shiftLane((uint32_t)wide) ^ (uint32_t)crc1) ^
+               (uint32_t)crc2;
+        data += 3 * LANE_BYTES;
+        size -= 3 * LANE_BYTES;
+    }
+    while (size >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = (uint32_t)wide;
+#endif
+    while (size > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+        size--;
+    }
+    return crc;
+}
+
+/**
+ * Ask the CPU whether it has SSE4.2 (once, at start-up).
+ */
+static bool detectSse42() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+static const bool hasSse42 = detectSse42();
+#else
+static const bool hasSse42 = false;
+#endif
+
+bool crc32cHardware() {
+    return hasSse42;
+}
+
+uint32_t crc32c(const unsigned char* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+#ifdef HAVE_SSE42_CRC
+    if (hasSse42) {
+        return ~crc32cSse42(crc, data, size);
+    }
+#endif
+    return ~crc32cSoftware(crc, data, size);
+}
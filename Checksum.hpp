@@ -0,0 +1,34 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Intel SSE4.2 CRC32 instruction reference, RFC 3720
+ *               (CRC32C / Castagnoli polynomial).
+ *
+ * This file provides the CRC32C checksum used to protect the blocks of the
+ * block format. It uses the SSE4.2 crc32 instruction when the CPU has it
+ * and a lookup table otherwise; both give the same result.
+ */
+
+#ifndef CHECKSUM_HPP
+#define CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compute (or continue) the CRC32C of a buffer.
+ *
+ * @param data the bytes to checksum
+ * @param size how many bytes
+ * @param crc the CRC32C of the preceding bytes, 0 to start a new one
+ * @return the CRC32C of all the bytes so far
+ */
+uint32_t crc32c(const unsigned char* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @return true if crc32c() uses the SSE4.2 instruction on this CPU
+ */
+bool crc32cHardware();
+
+#endif // CHECKSUM_HPP
@@ -0,0 +1,198 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the implementation of whole-buffer compression and
+ * decompression.
+ */
+
+#include "Codec.hpp"
+#include "BlockFormat.hpp"
+#include "HCTree.hpp"
+#include "Helper.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Largest block used when compressing a buffer to the block format.
+static const size_t MEMORY_BLOCK_SIZE = 1 << 20;
+
+void compressMemory(const unsigned char* data, size_t size, bool blockFormat,
+                    unsigned char flags, vector<unsigned char>& out,
+                    const EncodeOptions& options) {
+    out.clear();
+
+    if (blockFormat) {
+        FileHeader header = {BLOCK_VERSION, flags, MEMORY_BLOCK_SIZE, size};
+        writeFileHeader(header, out);
+        for (size_t pos = 0; pos < size; pos += MEMORY_BLOCK_SIZE) {
+            encodeBlock(data + pos, min(MEMORY_BLOCK_SIZE, size - pos),
+                        header, out, options);
+        }
+        writeEndBlock(header, out);
+        return;
+    }
+
+    // Single stream: count, build the tree, then serialize and encode.
+    HCTree& tree = threadTree();
+    vector<int> symFreq(256);
+    for (size_t i = 0; i < size; i++) {
+        symFreq[data[i]]++;
+    }
+    tree.build(symFreq);
+
+    BitWriter bits(out);
+    tree.serialize(bits);
+    tree.encodeBlock(data, size, bits);
+    bits.flush();
+}
+
+void decompressMemory(const unsigned char* data, size_t size,
+                      vector<unsigned char>& out, uint64_t maxSize) {
+    out.clear();
+
+    BitReader bits(data, size);
+    int totalFreq = bits.read<int>();
+
+    // An empty file stays empty.
+    if (!bits.good()) {
+        return;
+    }
+
+    if ((uint32_t)totalFreq == BLOCK_MAGIC) {
+        FileHeader header = readFileHeader(bits);
+        BlockHeader block;
+        vector<unsigned char> payload;
+        while (readBlockHeader(bits, header, block)) {
+            payload.resize(block.payloadSize);
+            bits.readBytes(payload.data(), block.payloadSize);
+            if (!bits.good()) {
+                error("Truncated block");
+            }
+            size_t written = out.size();
+            if (block.rawSize > maxSize - written) {
+                error("Output too large");
+            }
+            out.resize(written + block.rawSize);
+            decodeBlock(header, block, payload.data(), &out[written]);
+        }
+        if (header.totalSize != UNKNOWN_SIZE &&
+            out.size() != header.totalSize) {
+            error("Truncated input");
+        }
+        return;
+    }
+
+    if (totalFreq < 0) {
+        error("Corrupt input");
+    }
+
+    HCTree& tree = threadTree();
+    tree.deserialize((int)min<size_t>(size - sizeof(int), INT_MAX), bits);
+
+    // The rest of the input bounds the count.
+    uint64_t bitsLeft = (uint64_t)size * 8 - min<uint64_t>(bits.position(),
+                                                           size * 8);
+    if ((uint64_t)totalFreq > maxSize ||
+        !tree.countFits(totalFreq, bitsLeft)) {
+        error("Corrupt input");
+    }
+    out.resize(totalFreq);
+    tree.decodeBlock(bits, out.data(), totalFreq);
+}
+
+void readWholeFile(const string& path, vector<unsigned char>& out) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error("Cannot open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        error("Cannot stat " + path + ": " + strerror(errno));
+    }
+    out.resize(st.st_size);
+
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = read(fd, out.data() + done, out.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            error("Cannot read " + path);
+        }
+        done += n;
+    }
+    close(fd);
+}
+
+void writeFully(int fd, const unsigned char* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(fd, data + done, size - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error("Cannot write output: " + string(strerror(errno)));
+        }
+        done += n;
+    }
+}
+
+void writeWholeFile(const string& path, const vector<unsigned char>& data) {
+
+    // Create the parent directories one level at a time.
+    for (size_t slash = path.find('/', 1); slash != string::npos;
+         slash = path.find('/', slash + 1)) {
+        string dir = path.substr(0, slash);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            error("Cannot create " + dir + ": " + strerror(errno));
+        }
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error("Cannot create " + path + ": " + strerror(errno));
+    }
+    try {
+        writeFully(fd, data.data(), data.size());
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+size_t parseSize(const char* text) {
+    char* end;
+    size_t size = strtoull(text, &end, 10);
+    switch (*end) {
+    case 'K': case 'k':
+        size <<= 10;
+        end++;
+        break;
+    case 'M': case 'm':
+        size <<= 20;
+        end++;
+        break;
+    case 'G': case 'g':
+        size <<= 30;
+        end++;
+        break;
+    }
+    if (end == text || *end != '\0') {
+        error("Incorrect size " + string(text));
+    }
+    return size;
+}
@@ -0,0 +1,83 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides whole-buffer compression and decompression in
+ * memory, for callers that handle many small inputs (batch mode, archive
+ * extraction) and would only pay for the pipeline's threads and blocks.
+ * The bytes produced are the same as compress/decompress would write.
+ */
+
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "BlockFormat.hpp"
+using namespace std;
+
+/**
+ * Compress a whole buffer.
+ *
+ * @param data the input bytes
+ * @param size how many bytes
+ * @param blockFormat true for the block format, false for single stream
+ * @param flags the block format flags (ignored for single stream)
+ * @param out set to the compressed bytes (its memory is reused)
+ * @param options how to code each block (block format only)
+ */
+void compressMemory(const unsigned char* data, size_t size, bool blockFormat,
+                    unsigned char flags, vector<unsigned char>& out,
+                    const EncodeOptions& options = EncodeOptions());
+
+/**
+ * Decompress a whole buffer in either format.
+ *
+ * @param data the compressed bytes
+ * @param size how many bytes
+ * @param out set to the decompressed bytes (its memory is reused)
+ * @param maxSize largest output accepted; a header claiming more is
+ *        refused before anything is allocated
+ */
+void decompressMemory(const unsigned char* data, size_t size,
+                      vector<unsigned char>& out,
+                      uint64_t maxSize = UINT64_MAX);
+
+/**
+ * Read a whole file.
+ *
+ * @param path the file
+ * @param out set to the contents of the file (its memory is reused)
+ */
+void readWholeFile(const string& path, vector<unsigned char>& out);
+
+/**
+ * Write all of a buffer to a file descriptor, retrying short writes.
+ *
+ * @param fd the file
+ * @param data the bytes
+ * @param size how many bytes
+ */
+void writeFully(int fd, const unsigned char* data, size_t size);
+
+/**
+ * Write a whole file, creating missing parent directories.
+ *
+ * @param path the file
+ * @param data the contents
+ */
+void writeWholeFile(const string& path, const vector<unsigned char>& data);
+
+/**
+ * Parse a size given on the command line, such as 512K, 64M or 1G.
+ *
+ * @param text the size, in bytes unless it has a K, M or G suffix
+ * @return the size in bytes
+ */
+size_t parseSize(const char* text);
+
+#endif // CODEC_HPP
@@ -12,15 +12,15 @@
 
 #include "HCTree.hpp"
 #include <algorithm>
+#include <cstring>
 
     /**
      * Deconstructor, which deletes all nodes in the tree.
      */
 HCTree::~HCTree() {
     
-    // Clears all nodes in the tree, recursively starting
-    // from the root.
-    clear(root);
+    // Clears all nodes in the tree.
+    clear();
 }
 
 /**
@@ -34,6 +34,9 @@ HCTree::~HCTree() {
  */
 void HCTree::build(const vector<int>& freqs) {
 
+    // Start from an empty tree (the tree may be reused).
+    clear();
+
     // Queue to store the Huffman node trees in min-heap order
     priority_queue<HCNode*, vector<HCNode*>, HCNodePtrComp> pq;
 
@@ -45,7 +48,7 @@ void HCTree::build(const vector<int>& freqs) {
     // push it to the priority queue (pq).
     for (int i = 0; i < freqTableSize; i++) {
         if (freqs[i] != 0) {
-            HCNode* h = new HCNode(freqs[i], (unsigned char)i);
+            HCNode* h = newNode(freqs[i], (unsigned char)i);
 
             // Store the single-node trees in min-heap order
             pq.push(h);
@@ -75,7 +78,7 @@ void HCTree::build(const vector<int>& freqs) {
 
         // Create a new node, and make it the parent of the
         // two smallest trees, combining into a larger tree.
-        HCNode* h = new HCNode(freqSum, '`');
+        HCNode* h = newNode(freqSum, '`');
         h->c0 = tree1;
         h->c1 = tree2;
         tree1->p = h;
@@ -92,8 +95,9 @@ void HCTree::build(const vector<int>& freqs) {
     } else {
         root = nullptr;
     }
-    
 
+    // Derive the code and decoding tables from the new tree.
+    buildTables();
 }
 
 /**
@@ -177,200 +181,179 @@ unsigned char HCTree::decode(FancyInputStream & in) const{
 }
 
 /**
- * Removes all nodes from the Huffman tree. It is called when
- * the tree destructor is used.
- * 
- * @param treeNode the current node we are lookign at.
+ * Write to the given BitWriter the code of the given symbol, using the
+ * code table instead of walking the tree.
+ * PRECONDITION: build() has been called.
+ *
+ * @param symbol symbol to encode
+ * @param out bit writer for the encoded bits
  */
-void HCTree::clear(HCNode* treeNode) {
+void HCTree::encode(unsigned char symbol, BitWriter & out) const {
+    out.write_bits(codes[symbol], codeLengths[symbol]);
+}
 
-    // Base case: if we already reached a leaf node, return
-    if (treeNode ==  nullptr) {
-        return;
+/**
+ * Encode every byte of a buffer.
+ * PRECONDITION: build() has been called.
+ *
+ * @param data the bytes to encode
+ * @param size how many bytes
+ * @param out bit writer for the encoded bits
+ */
+void HCTree::encodeBlock(const unsigned char* data, size_t size,
+                         BitWriter & out) const {
+    for (size_t i = 0; i < size; i++) {
+        out.write_bits(codes[data[i]], codeLengths[data[i]]);
     }
-
-    // Recursively delete the left and right child
-    clear(treeNode->c0);
-    clear(treeNode->c1);
-
-    // Delete the current node itself.
-    delete(treeNode);
 }
 
 /**
- * Serializes the path of the current node (from the root)
- * and writes it to the output stream.
+ * Return symbol coded in the next bits of the BitReader, looking up
+ * TABLE_BITS bits at a time instead of walking the tree bit by bit.
+ * PRECONDITION: build() or deserialize() has been called.
  *
- * @param currNode the current node we are looking at (recursive)
- * @param out the output stream.
+ * @param in bit reader to find encoded bits
+ * @return a single char decoded from the bit reader
  */
-void HCTree::serialization(HCNode* currNode, FancyOutputStream & out){
+unsigned char HCTree::decode(BitReader & in) const {
 
-    const int byteMSBIndex = 7;
-    // If the current node we are looking at is the root, write its
-    // frequency (i.e the total frequency of the file) to the header
-    // of the output stream to store it.
-
-    if (root == nullptr) {
-        return;
+    // A tree with a single symbol codes it with zero bits.
+    if (root->c0 == nullptr || root->c1 == nullptr) {
+        return root->symbol;
     }
 
-    if (currNode == root) {
-        out.write<int>(currNode->count);
+    // Codes of up to TABLE_BITS bits are resolved by a single lookup.
+    const DecodeEntry& entry = decodeTable[in.peek(TABLE_BITS)];
+    if (entry.length != 0) {
+        in.skip(entry.length);
+        return entry.symbol;
     }
-    
-    // Base case: if we reach a null reference then return.
-    if (currNode == nullptr) {
-        return;
+
+    // Longer codes continue from the node reached after TABLE_BITS bits.
+    if (entry.node == nullptr) {
+        error("Corrupt Huffman code");
     }
+    in.skip(TABLE_BITS);
 
-    // If we reach a leaf node, write a '1'
-    // followed by a byte representation of the symbol to the output stream.
-    // (Serialization algorithm seen in lecture)
-    if (currNode->c0 == nullptr && currNode->c1 == nullptr){
-        out.write_bit(1);
-
-        // The character we are going to write to the output stream
-        // in bits.
-        char nodeChar = currNode->symbol;
-
-        // Read the character (8 bits) from left (MSB) to right (LSB),
-        // and write each bit to the output stream.
-        for (int i = byteMSBIndex; i >= 0; i--) {
-
-            //Bitwise operation to check if bit at ith position
-            //from the right is a 1, then write a 1 and 0 otherwise.
-            if (((nodeChar & (1<<i)) >> i) == 1) {
-                out.write_bit(1);
-            
-            } else {
-                out.write_bit(0);
-            }
+    HCNode* currNode = entry.node;
+    while (currNode->c0 != nullptr && currNode->c1 != nullptr) {
+        if (in.read_bit() == 0) {
+            currNode = currNode->c0;
+        } else {
+            currNode = currNode->c1;
         }
-
-    } else {
-
-        // If we havent reached a leaf node, write a '0' bit to the output.
-        out.write_bit(0);
     }
-
-    // Recursively call this function on the left and right child.
-    serialization(currNode->c0, out);
-    serialization(currNode->c1, out);
+    return currNode->symbol;
 }
 
 /**
- * Represents the tree as its serialized verson and stores it in
- * the output stream by calling serialization() on the root node.
- * PRECONDITION: The output stream is functioning correctly
- *               and tree has more than one node (i.e there is at least
- *               one symbol).
+ * Decode count symbols from the BitReader into out. Symbols are gathered
+ * into 8-byte words and stored with one wide store each, which matters
+ * when out is a memory mapped file.
+ * PRECONDITION: build() or deserialize() has been called.
  *
- * @param out the output stream.
+ * @param in bit reader to find encoded bits
+ * @param out where to store the decoded symbols
+ * @param count how many symbols to decode
  */
-void HCTree::serialize(FancyOutputStream & out) {
+void HCTree::decodeBlock(BitReader & in, unsigned char* out,
+                         size_t count) const {
+    size_t i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // The first symbol goes to the lowest byte of the word.
+    for (; i + 8 <= count; i += 8) {
+        uint64_t word = 0;
+        for (int j = 0; j < 8; j++) {
+            word |= (uint64_t)decode(in) << (8 * j);
+        }
+        memcpy(out + i, &word, sizeof(word));
+    }
+#endif
 
-    // Call serialization() starting at the root of the tree.
-    serialization(root, out);
+    for (; i < count; i++) {
+        out[i] = decode(in);
+    }
+}
 
-    // Write the buffer to the output file (including any padding that
-    // is needed)
-    out.flush();
+/**
+ * Rebuild codes, codeLengths and decodeTable from the tree.
+ * Called whenever the tree is built or deserialized.
+ */
+void HCTree::buildTables() {
+    DecodeEntry empty = {nullptr, 0, 0};
+    decodeTable.assign(1 << TABLE_BITS, empty);
+    codes.assign(256, 0);
+    codeLengths.assign(256, 0);
+
+    if (root != nullptr) {
+        fillTables(root, 0, 0);
+    }
 }
 
 /**
- * Deserializes the current index of the bitstring
- * from the input stream and creates the huffman tree node structure.
- * (Called recursively).
- * PRECONDITION: The input stream stores the serialized tree correctly
- *               and in the right location. The read header is in the
- *               correct location.
+ * Fill in the tables for the subtree rooted at node.
  *
- * @param index the current index of the bitstring.
- * @param len the length of the serialized tree bitstring.
- * @param in the input stream.
- * @param bitcounter how bits have been read
+ * @param node the current node (recursive)
+ * @param code the path from the root to node
+ * @param depth the length of that path
  */
-HCNode* HCTree::deseriallization(int& index, int len, FancyInputStream& in, int &bitcounter){
-
-        // If we reach an index that is greater than the bitstring than return null.
-        if (index >= len) return nullptr;
-
-        // Read a bit from the input stream.
-        int bit = in.read_bit();
-
-        // Increment our bitcounter
-        bitcounter++;
+void HCTree::fillTables(HCNode* node, uint64_t code, int depth) {
+    if (node == nullptr) {
+        return;
+    }
 
-        // If the bit we read is a 0, then construct a empty node
-        // and recursively call this function to create its
-        // left and right children.
-        if (bit == 0){
-            HCNode* curr = new HCNode(0, '`');
-            curr->c0= deseriallization(++index, len, in, bitcounter);
-            curr->c1= deseriallization(++index, len, in, bitcounter);
-            return curr;
-        
-        // If the bit we read is a 1, then the next 8 bits represent
-        // a symbol. Obtain the symbol
-        } else {
-            
-            // The Symbol c we are obtaining.
-            unsigned char decodedChar = 0;
-
-            // Iterates 8 times to get 8 bits
-            for (int i = 7; i >= 0; i--) {
-
-                // The bit we obtain from the input stream
-                bit = in.read_bit();
-                // Increment the bit counter (how many bits we've read)
-                bitcounter++;
-
-                // If the bit is 1, set the bit at the ith position
-                // from the right of symbol c to 1 and 0 otherwise
-                if (bit == 1) {
-                    decodedChar = (decodedChar&~(1<<i)) | ((1<<i));
-                } else {
-                    decodedChar = (decodedChar&~(1<<i)) | ((0<<i));
-                }
+    // Leaf: record its code, and if it fits in the table, every table
+    // index that starts with the code decodes to this symbol.
+    if (node->c0 == nullptr && node->c1 == nullptr) {
+        codes[node->symbol] = code;
+        codeLengths[node->symbol] = depth;
+
+        if (depth > 0 && depth <= TABLE_BITS) {
+            int spare = TABLE_BITS - depth;
+            DecodeEntry entry = {node, node->symbol, (unsigned char)depth};
+            for (uint64_t i = code << spare; i < (code + 1) << spare; i++) {
+                decodeTable[i] = entry;
             }
+        }
+        return;
+    }
 
-            // Create a new leaf node for this symbol.
-            HCNode* curr = new HCNode(0, decodedChar);
-            leaves[(int)decodedChar] = curr;
+    // Internal node at the table boundary: decoding walks on from here.
+    if (depth == TABLE_BITS) {
+        DecodeEntry entry = {node, 0, 0};
+        decodeTable[code] = entry;
+    }
 
-            // Return the node (because of the recursive call earlier).
-            return curr;
-        }  
+    fillTables(node->c0, code << 1, depth + 1);
+    fillTables(node->c1, (code << 1) | 1, depth + 1);
 }
 
 /**
- * Deserializes the huffman tree stored in the header of the input stream.
- * PRECONDITION: The input stream stores the serialized tree correctly
- *               and in the right location. The read header is in the
- *               correct location.
- *
- * @param len the length of the serialized tree bit string.
- * @param in the input stream.
+ * Removes all nodes from the Huffman tree, keeping the memory of the
+ * node pool for the next build. It is called when the tree is
+ * (re)built or deserialized, and when the tree destructor is used.
  */
-void HCTree::deserialize(int len, FancyInputStream & in) {
-
-    // The start of the bitstring that represents the tree
-    int index = 0;
+void HCTree::clear() {
+    nodes.clear();
+    root = nullptr;
+    fill(leaves.begin(), leaves.end(), nullptr);
+}
 
-    // How many bits we will read because of the deserialization
-    int bitcounter = 0;
+/**
+ * Take a new node from the pool.
+ *
+ * @param count the count of the node
+ * @param symbol the symbol of the node
+ * @return the new node
+ */
+HCNode* HCTree::newNode(int count, unsigned char symbol) {
 
-    // Set the root node to the node returned from deserialization.
-    root = deseriallization(index, len, in, bitcounter);
-    
-    // Using bit counter, see how many times we read a bit and mod
-    // it by 8 to see how far into a byte we have already read (1-8). 
-    // Then, because of padding we need to read the extra padded '0' bits
-    // to align our readheader to the start of the next byte.
-    const int bytesize = 8;
-
-    for (int i = 0; i < (bytesize-(bitcounter%bytesize)); i++){
-        in.read_bit();
+    // Growing the pool would move the nodes; only a corrupt serialized
+    // tree can have this many.
+    if (nodes.size() == nodes.capacity()) {
+        error("Too many nodes in Huffman tree");
     }
-}
\ No newline at end of file
+    nodes.push_back(HCNode(count, symbol));
+    return &nodes.back();
+}
@@ -12,12 +12,25 @@
 
 #ifndef HCTREE_HPP
 #define HCTREE_HPP
+#include <cstdint>
 #include <queue>
 #include <vector>
 #include <fstream>
 #include "Helper.hpp"
+#include "BitIO.hpp"
 using namespace std;
 
+/**
+ * One entry of the flat decoding table. If length is non-zero, the next
+ * length bits code symbol. Otherwise the code is longer than the table
+ * and decoding continues by walking the tree from node.
+ */
+struct DecodeEntry {
+    HCNode* node;
+    unsigned char symbol;
+    unsigned char length;
+};
+
 /**
  * A Huffman Code Tree class
  */
@@ -28,12 +41,58 @@ private:
     HCNode* root;
     vector<HCNode*> leaves;
 
+    // A tree over 256 symbols never has more than 511 nodes.
+    static const size_t MAX_NODES = 511;
+
+    // Every node of the tree lives in this pool. It is reserved once, so
+    // node pointers stay valid and rebuilding the tree (e.g. for the next
+    // block or file) allocates nothing.
+    vector<HCNode> nodes;
+
+    /**
+     * Take a new node from the pool.
+     *
+     * @param count the count of the node
+     * @param symbol the symbol of the node
+     * @return the new node
+     */
+    HCNode* newNode(int count, unsigned char symbol);
+
+    // Number of bits looked up at once by the table decoder.
+    static const int TABLE_BITS = 10;
+
+    // The code of every symbol (root-to-leaf path, first bit as the MSB)
+    // and its length, so encoding does not need to walk the tree.
+    vector<uint64_t> codes;
+    vector<unsigned char> codeLengths;
+
+    // Flat decoding table indexed by the next TABLE_BITS bits.
+    vector<DecodeEntry> decodeTable;
+
+    /**
+     * Rebuild codes, codeLengths and decodeTable from the tree.
+     * Called whenever the tree is built or deserialized.
+     */
+    void buildTables();
+
+    /**
+     * Fill in the tables for the subtree rooted at node.
+     *
+     * @param node the current node (recursive)
+     * @param code the path from the root to node
+     * @param depth the length of that path
+     */
+    void fillTables(HCNode* node, uint64_t code, int depth);
+
 public:
     /**
      * Constructor, which initializes everything to null pointers
      */
     HCTree() : root(nullptr) {
         leaves = vector<HCNode*>(256, nullptr);
+        nodes.reserve(MAX_NODES);
+        codes = vector<uint64_t>(256, 0);
+        codeLengths = vector<unsigned char>(256, 0);
     }
 
     /**
@@ -63,6 +122,27 @@ public:
      */
     void encode(unsigned char symbol, FancyOutputStream & out) const;
 
+    /**
+     * Write to the given BitWriter the code of the given symbol, using the
+     * code table instead of walking the tree.
+     * PRECONDITION: build() has been called.
+     *
+     * @param symbol symbol to encode
+     * @param out bit writer for the encoded bits
+     */
+    void encode(unsigned char symbol, BitWriter & out) const;
+
+    /**
+     * Encode every byte of a buffer.
+     * PRECONDITION: build() has been called.
+     *
+     * @param data the bytes to encode
+     * @param size how many bytes
+     * @param out bit writer for the encoded bits
+     */
+    void encodeBlock(const unsigned char* data, size_t size,
+                     BitWriter & out) const;
+
     /**
      * Return symbol coded in the next sequence of bits from the stream.
      * PRECONDITION: build() has been called, to create the coding tree, and
@@ -74,21 +154,73 @@ public:
     unsigned char decode(FancyInputStream & in) const;
 
     /**
-     * Removes all nodes from the Huffman tree. It is called when
-     * the tree destructor is used.
-     * 
-     * @param treeNode the current node we are looking at
+     * Return symbol coded in the next bits of the BitReader, looking up
+     * TABLE_BITS bits at a time instead of walking the tree bit by bit.
+     * PRECONDITION: build() or deserialize() has been called.
+     *
+     * @param in bit reader to find encoded bits
+     * @return a single char decoded from the bit reader
+     */
+    unsigned char decode(BitReader & in) const;
+
+    /**
+     * Decode count symbols from the BitReader into out.
+     * PRECONDITION: build() or deserialize() has been called.
+     *
+     * @param in bit reader to find encoded bits
+     * @param out where to store the decoded symbols
+     * @param count how many symbols to decode
+     */
+    void decodeBlock(BitReader & in, unsigned char* out, size_t count) const;
+
+    /**
+     * PRECONDITION: build() or deserialize() has been called.
+     *
+     * @param symbol the symbol
+     * @return the length of its code in bits (0 if it has none)
      */
-    void clear(HCNode* treeNode);
+    int codeLength(unsigned char symbol) const {
+        return codeLengths[symbol];
+    }
+
+    /**
+     * @return true if the tree has a single symbol, which is coded with
+     *         zero bits (so a bitstream has no symbol boundaries)
+     */
+    bool singleSymbol() const {
+        return root != nullptr && (root->c0 == nullptr || root->c1 == nullptr);
+    }
+
+    /**
+     * PRECONDITION: build() or deserialize() has been called.
+     *
+     * Every code takes at least one bit unless the tree has a single
+     * symbol, so the input left bounds how many symbols a stream can hold.
+     *
+     * @param count a symbol count read from a header
+     * @param bitsLeft the bits there are to decode them from
+     * @return false if count symbols can not be in that many bits
+     */
+    bool countFits(uint64_t count, uint64_t bitsLeft) const {
+        return singleSymbol() || count <= bitsLeft;
+    }
+
+    /**
+     * Removes all nodes from the Huffman tree, keeping the memory of the
+     * node pool for the next build. It is called when the tree is
+     * (re)built or deserialized, and when the tree destructor is used.
+     */
+    void clear();
 
     /**
      * Serializes the path of the current node (from the root)
      * and writes it to the output stream.
      *
      * @param currNode the current node we are looking at (recursive)
-     * @param out the output stream.
+     * @param out the output stream (FancyOutputStream or BitWriter).
      */
-    void serialization(HCNode* currNode, FancyOutputStream & out);
+    template<typename Out>
+    void serialization(HCNode* currNode, Out & out);
 
     /**
      * Represents the tree as its serialized verson and stores it in
@@ -97,9 +229,10 @@ public:
      *               and tree has more than one node (i.e there is at least
      *               one symbol).
      *
-     * @param out the output stream.
+     * @param out the output stream (FancyOutputStream or BitWriter).
      */
-    void serialize(FancyOutputStream & out);
+    template<typename Out>
+    void serialize(Out & out);
 
     /**
      * Deserializes the current index of the bitstring
@@ -111,10 +244,11 @@ public:
      *
      * @param index the current index of the bitstring.
      * @param len the length of the serialized tree bitstring.
-     * @param in the input stream.
+     * @param in the input stream (FancyInputStream or BitReader).
      * @param bitcounter how bits have been read
      */
-    HCNode* deseriallization(int& index, int len, FancyInputStream & in, int& bitcounter);
+    template<typename In>
+    HCNode* deseriallization(int& index, int len, In & in, int& bitcounter);
 
     /**
      * Deserializes the huffman tree stored in the header of the input stream.
@@ -123,8 +257,13 @@ public:
      *               correct location.
      *
      * @param len the length of the serialized tree bit string.
-     * @param in the input stream.
+     * @param in the input stream (FancyInputStream or BitReader).
      */
-    void deserialize(int len, FancyInputStream & in);
+    template<typename In>
+    void deserialize(int len, In & in);
 };
+
+#include "HCTree.tcc" // template implementations need to be visible to
+// the compiler in the header file
+
 #endif // HCTREE_HPP
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides and Stepik 8.3.
+ *
+ * This file provides the template implementations for serializing and
+ * deserializing the huffman tree. They work on any stream with the
+ * read_bit/write_bit/read<T>/write<T> interface, i.e. FancyInputStream/
+ * FancyOutputStream as well as BitReader/BitWriter.
+ */
+
+
+/**
+ * Serializes the path of the current node (from the root)
+ * and writes it to the output stream.
+ *
+ * @param currNode the current node we are looking at (recursive)
+ * @param out the output stream (FancyOutputStream or BitWriter).
+ */
+template<typename Out>
+void HCTree::serialization(HCNode* currNode, Out & out){
+
+    const int byteMSBIndex = 7;
+    // If the current node we are looking at is the root, write its
+    // frequency (i.e the total frequency of the file) to the header
+    // of the output stream to store it.
+
+    if (root == nullptr) {
+        return;
+    }
+
+    if (currNode == root) {
+        out.template write<int>(currNode->count);
+    }
+    
+    // Base case: if we reach a null reference then return.
+    if (currNode == nullptr) {
+        return;
+    }
+
+    // If we reach a leaf node, write a '1'
+    // followed by a byte representation of the symbol to the output stream.
+    // (Serialization algorithm seen in lecture)
+    if (currNode->c0 == nullptr && currNode->c1 == nullptr){
+        out.write_bit(1);
+
+        // The character we are going to write to the output stream
+        // in bits.
+        char nodeChar = currNode->symbol;
+
+        // Read the character (8 bits) from left (MSB) to right (LSB),
+        // and write each bit to the output stream.
+        for (int i = byteMSBIndex; i >= 0; i--) {
+
+            //Bitwise operation to check if bit at ith position
+            //from the right is a 1, then write a 1 and 0 otherwise.
+            if (((nodeChar & (1<<i)) >> i) == 1) {
+                out.write_bit(1);
+            
+            } else {
+                out.write_bit(0);
+            }
+        }
+
+    } else {
+
+        // If we havent reached a leaf node, write a '0' bit to the output.
+        out.write_bit(0);
+    }
+
+    // Recursively call this function on the left and right child.
+    serialization(currNode->c0, out);
+    serialization(currNode->c1, out);
+}
+
+/**
+ * Represents the tree as its serialized verson and stores it in
+ * the output stream by calling serialization() on the root node.
+ * PRECONDITION: The output stream is functioning correctly
+ *               and tree has more than one node (i.e there is at least
+ *               one symbol).
+ *
+ * @param out the output stream (FancyOutputStream or BitWriter).
+ */
+template<typename Out>
+void HCTree::serialize(Out & out) {
+
+    // Call serialization() starting at the root of the tree.
+    serialization(root, out);
+
+    // Write the buffer to the output file (including any padding that
+    // is needed)
+    out.flush();
+}
+
+/**
+ * Deserializes the current index of the bitstring
+ * from the input stream and creates the huffman tree node structure.
+ * (Called recursively).
+ * PRECONDITION: The input stream stores the serialized tree correctly
+ *               and in the right location. The read header is in the
+ *               correct location.
+ *
+ * @param index the current index of the bitstring.
+ * @param len the length of the serialized tree bitstring.
+ * @param in the input stream (FancyInputStream or BitReader).
+ * @param bitcounter how bits have been read
+ */
+template<typename In>
+HCNode* HCTree::deseriallization(int& index, int len, In& in, int &bitcounter){
+
+        // If we reach an index that is greater than the bitstring than return null.
+        if (index >= len) return nullptr;
+
+        // Read a bit from the input stream.
+        int bit = in.read_bit();
+
+        // Increment our bitcounter
+        bitcounter++;
+
+        // If the bit we read is a 0, then construct a empty node
+        // and recursively call this function to create its
+        // left and right children.
+        if (bit == 0){
+            HCNode* curr = newNode(0, '`');
+            curr->c0= deseriallization(++index, len, in, bitcounter);
+            curr->c1= deseriallization(++index, len, in, bitcounter);
+            return curr;
+        
+        // If the bit we read is a 1, then the next 8 bits represent
+        // a symbol. Obtain the symbol
+        } else {
+            
+            // The Symbol c we are obtaining.
+            unsigned char decodedChar = 0;
+
+            // Iterates 8 times to get 8 bits
+            for (int i = 7; i >= 0; i--) {
+
+                // The bit we obtain from the input stream
+                bit = in.read_bit();
+                // Increment the bit counter (how many bits we've read)
+                bitcounter++;
+
+                // If the bit is 1, set the bit at the ith position
+                // from the right of symbol c to 1 and 0 otherwise
+                if (bit == 1) {
+                    decodedChar = (decodedChar&~(1<<i)) | ((1<<i));
+                } else {
+                    decodedChar = (decodedChar&~(1<<i)) | ((0<<i));
+                }
+            }
+
+            // Create a new leaf node for this symbol.
+            HCNode* curr = newNode(0, decodedChar);
+            leaves[(int)decodedChar] = curr;
+
+            // Return the node (because of the recursive call earlier).
+            return curr;
+        }  
+}
+
+/**
+ * Deserializes the huffman tree stored in the header of the input stream.
+ * PRECONDITION: The input stream stores the serialized tree correctly
+ *               and in the right location. The read header is in the
+ *               correct location.
+ *
+ * @param len the length of the serialized tree bit string.
+ * @param in the input stream (FancyInputStream or BitReader).
+ */
+template<typename In>
+void HCTree::deserialize(int len, In & in) {
+
+    // Start from an empty tree (the tree may be reused).
+    clear();
+
+    // The start of the bitstring that represents the tree
+    int index = 0;
+
+    // How many bits we will read because of the deserialization
+    int bitcounter = 0;
+
+    // Set the root node to the node returned from deserialization.
+    root = deseriallization(index, len, in, bitcounter);
+    
+    // Using bit counter, see how many times we read a bit and mod
+    // it by 8 to see how far into a byte we have already read (1-8). 
+    // Then, because of padding we need to read the extra padded '0' bits
+    // to align our readheader to the start of the next byte.
+    const int bytesize = 8;
+
+    for (int i = 0; i < (bytesize-(bitcounter%bytesize)); i++){
+        in.read_bit();
+    }
+
+    // Derive the code and decoding tables from the new tree.
+    buildTables();
+}
@@ -0,0 +1,68 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: mmap(2) and posix_fallocate(3) man pages.
+ *
+ * This file provides the implementation of MappedFile.
+ */
+
+#include "MappedFile.hpp"
+#include "Helper.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Constructor, which maps the file open on fd.
+ *
+ * @param fd the open file (O_RDWR for an output mapping)
+ * @param size the size to map; an output file is first preallocated
+ *             and truncated to exactly this size
+ * @param writable true for an output mapping, false for read only
+ */
+MappedFile::MappedFile(int fd, size_t size, bool writable)
+    : bytes(nullptr), length(size) {
+
+    if (writable) {
+        // Set the exact size (dropping anything left from an older file),
+        // then reserve the disk blocks so page faults never hit ENOSPC.
+        if (ftruncate(fd, size) != 0) {
+            error("Cannot resize output file: " + string(strerror(errno)));
+        }
+        if (size > 0) {
+            int err = posix_fallocate(fd, 0, size);
+            if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+                error("Cannot allocate output file: " + string(strerror(err)));
+            }
+        }
+    }
+
+    // mmap rejects empty mappings; an empty file needs no memory anyway.
+    if (size == 0) {
+        return;
+    }
+
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    int flags = writable ? MAP_SHARED : MAP_PRIVATE;
+    void* ptr = mmap(nullptr, size, prot, flags, fd, 0);
+    if (ptr == MAP_FAILED) {
+        error("Cannot map file: " + string(strerror(errno)));
+    }
+    bytes = (unsigned char*)ptr;
+
+    // Both directions are walked front to back.
+    madvise(bytes, size, MADV_SEQUENTIAL);
+}
+
+/**
+ * Destructor, which unmaps the file
+ */
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        munmap(bytes, length);
+    }
+}
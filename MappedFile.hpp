@@ -0,0 +1,53 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: mmap(2) and posix_fallocate(3) man pages.
+ *
+ * This file provides a memory mapping of a whole file. An output mapping
+ * preallocates the file to its final size first, so that decoders can
+ * store symbols straight into the page cache (and several decoders can
+ * write disjoint parts of it) without any stream calls.
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+
+/**
+ * A file mapped into memory for the lifetime of the object.
+ */
+class MappedFile {
+private:
+    unsigned char* bytes; // start of the mapping (nullptr if size is 0)
+    size_t length;        // size of the mapping
+
+public:
+    /**
+     * Constructor, which maps the file open on fd.
+     *
+     * @param fd the open file (O_RDWR for an output mapping)
+     * @param size the size to map; an output file is first preallocated
+     *             and truncated to exactly this size
+     * @param writable true for an output mapping, false for read only
+     */
+    MappedFile(int fd, size_t size, bool writable);
+
+    /**
+     * Destructor, which unmaps the file
+     */
+    ~MappedFile();
+
+    /**
+     * @return the start of the mapping
+     */
+    unsigned char* data() const { return bytes; }
+
+    /**
+     * @return the size of the mapping
+     */
+    size_t size() const { return length; }
+};
+
+#endif // MAPPEDFILE_HPP
@@ -0,0 +1,336 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides the implementation of order-1 coding: context
+ * statistics, clustering, and the table-switching coders.
+ */
+
+#include "Order1.hpp"
+#include "HCTree.hpp"
+#include "Helper.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Blocks smaller than this are left to order-0 coding; the map and the
+// extra trees would not pay for themselves.
+static const size_t MIN_ORDER1_SIZE = 4096;
+
+// Rounds of k-means per cluster count (it usually settles sooner).
+static const int KMEANS_ROUNDS = 8;
+
+// A tree over 256 symbols has at most 511 nodes.
+static const int MAX_TREE_NODES = 511;
+
+// Estimated header cost: a serialized tree takes about ten bits per
+// symbol plus its count and padding, and the map takes 129 bytes.
+static const double TREE_BITS_PER_SYMBOL = 10;
+static const double TREE_BITS_FIXED = 40;
+static const double MAP_BITS = 129 * 8;
+
+/**
+ * How often every symbol follows every context in a block.
+ */
+struct ContextStats {
+    vector<uint32_t> counts;   // counts[context * 256 + symbol]
+    vector<uint32_t> totals;   // how often each context occurs
+    vector<int> active;        // contexts that occur, most frequent first
+    vector<vector<unsigned char> > symbols; // symbols seen per context
+};
+
+/**
+ * Count the contexts of a block. The first byte has context 0.
+ */
+static void countContexts(const unsigned char* data, size_t size,
+                          ContextStats& stats) {
+    stats.counts.assign(256 * 256, 0);
+    stats.totals.assign(256, 0);
+    stats.symbols.assign(256, vector<unsigned char>());
+    stats.active.clear();
+
+    unsigned char prev = 0;
+    for (size_t i = 0; i < size; i++) {
+        stats.counts[prev * 256 + data[i]]++;
+        prev = data[i];
+    }
+
+    for (int c = 0; c < 256; c++) {
+        for (int s = 0; s < 256; s++) {
+            uint32_t n = stats.counts[c * 256 + s];
+            if (n != 0) {
+                stats.totals[c] += n;
+                stats.symbols[c].push_back(s);
+            }
+        }
+        if (stats.totals[c] != 0) {
+            stats.active.push_back(c);
+        }
+    }
+
+    const vector<uint32_t>& totals = stats.totals;
+    stable_sort(stats.active.begin(), stats.active.end(),
+                [&](int a, int b) { return totals[a] > totals[b]; });
+}
+
+/**
+ * Estimated size in bits of a histogram coded with its own tree.
+ *
+ * @param hist 256 symbol counts
+ */
+static double histogramCost(const uint32_t* hist) {
+    double total = 0;
+    int distinct = 0;
+    for (int s = 0; s < 256; s++) {
+        if (hist[s] != 0) {
+            total += hist[s];
+            distinct++;
+        }
+    }
+    if (distinct == 0) {
+        return 0;
+    }
+
+    double bits = TREE_BITS_FIXED + TREE_BITS_PER_SYMBOL * distinct;
+    for (int s = 0; s < 256; s++) {
+        if (hist[s] != 0) {
+            bits += hist[s] * log2(total / hist[s]);
+        }
+    }
+    return bits;
+}
+
+/**
+ * Ideal code lengths for a histogram, smoothed so that a symbol it has not
+ * seen yet is expensive instead of impossible.
+ *
+ * @param hist 256 symbol counts
+ * @param lengths set to 256 code lengths in bits
+ */
+static void codeCosts(const uint32_t* hist, double* lengths) {
+    double total = 0;
+    for (int s = 0; s < 256; s++) {
+        total += hist[s];
+    }
+    for (int s = 0; s < 256; s++) {
+        lengths[s] = log2((total + 128) / (hist[s] + 0.5));
+    }
+}
+
+/**
+ * Cluster the contexts into at most k groups with k-means, where the
+ * distance of a context to a group is the size of its symbols when coded
+ * with the group's histogram.
+ *
+ * @param stats the context statistics (k <= number of active contexts)
+ * @param k the number of groups
+ * @param assign set to the group of each context
+ * @return the estimated coded size in bits
+ */
+static double clusterContexts(const ContextStats& stats, int k,
+                              vector<int>& assign) {
+    assign.assign(256, 0);
+    vector<double> lengths(k * 256);
+    vector<uint32_t> hist(k * 256);
+
+    // Seed the groups with the k most frequent contexts.
+    for (int j = 0; j < k; j++) {
+        codeCosts(&stats.counts[stats.active[j] * 256], &lengths[j * 256]);
+    }
+
+    for (int round = 0; round < KMEANS_ROUNDS; round++) {
+
+        // Move every context to the group that codes it best.
+        bool changed = false;
+        for (size_t a = 0; a < stats.active.size(); a++) {
+            int c = stats.active[a];
+            const uint32_t* counts = &stats.counts[c * 256];
+            const vector<unsigned char>& symbols = stats.symbols[c];
+
+            int best = 0;
+            double bestCost = 0;
+            for (int j = 0; j < k; j++) {
+                const double* len = &lengths[j * 256];
+                double cost = 0;
+                for (size_t i = 0; i < symbols.size(); i++) {
+                    cost += counts[symbols[i]] * len[symbols[i]];
+                }
+                if (j == 0 || cost < bestCost) {
+                    best = j;
+                    bestCost = cost;
+                }
+            }
+            if (round == 0 || assign[c] != best) {
+                changed = true;
+                assign[c] = best;
+            }
+        }
+
+        // Recompute the histogram of every group.
+        fill(hist.begin(), hist.end(), 0);
+        for (size_t a = 0; a < stats.active.size(); a++) {
+            int c = stats.active[a];
+            for (int s : stats.symbols[c]) {
+                hist[assign[c] * 256 + s] += stats.counts[c * 256 + s];
+            }
+        }
+        if (!changed) {
+            break;
+        }
+        for (int j = 0; j < k; j++) {
+            codeCosts(&hist[j * 256], &lengths[j * 256]);
+        }
+    }
+
+    double bits = MAP_BITS;
+    for (int j = 0; j < k; j++) {
+        bits += histogramCost(&hist[j * 256]);
+    }
+    return bits;
+}
+
+/**
+ * Each thread keeps one tree per cluster and reuses them for every block.
+ *
+ * @return this thread's MAX_CLUSTERS trees
+ */
+static HCTree* threadTrees() {
+    static thread_local HCTree trees[MAX_CLUSTERS];
+    return trees;
+}
+
+bool encodeOrder1(const unsigned char* data, size_t size,
+                  vector<unsigned char>& out) {
+    if (size < MIN_ORDER1_SIZE) {
+        return false;
+    }
+
+    ContextStats stats;
+    countContexts(data, size, stats);
+
+    // Order-0 is the baseline: one tree for every context.
+    vector<uint32_t> order0(256);
+    for (int c = 0; c < 256; c++) {
+        for (int s = 0; s < 256; s++) {
+            order0[s] += stats.counts[c * 256 + s];
+        }
+    }
+    double bestBits = histogramCost(order0.data());
+
+    // Try 2, 4, 8 and 16 groups and keep the cheapest.
+    vector<int> best;
+    vector<int> assign;
+    for (int k = 2; k <= MAX_CLUSTERS; k *= 2) {
+        if ((size_t)k > stats.active.size()) {
+            break;
+        }
+        double bits = clusterContexts(stats, k, assign);
+        if (bits < bestBits) {
+            bestBits = bits;
+            best = assign;
+        }
+    }
+    if (best.empty()) {
+        return false;
+    }
+
+    // Number the groups that ended up with contexts 0..k-1; contexts that
+    // never occur go to group 0.
+    int remap[MAX_CLUSTERS];
+    fill(remap, remap + MAX_CLUSTERS, -1);
+    int k = 0;
+    for (size_t a = 0; a < stats.active.size(); a++) {
+        int c = stats.active[a];
+        if (remap[best[c]] < 0) {
+            remap[best[c]] = k++;
+        }
+    }
+    vector<unsigned char> group(256, 0);
+    for (size_t a = 0; a < stats.active.size(); a++) {
+        int c = stats.active[a];
+        group[c] = remap[best[c]];
+    }
+
+    // Build a tree per group, and point every context at its tree.
+    HCTree* trees = threadTrees();
+    vector<vector<int> > freqs(k, vector<int>(256));
+    for (size_t a = 0; a < stats.active.size(); a++) {
+        int c = stats.active[a];
+        for (int s : stats.symbols[c]) {
+            freqs[group[c]][s] += stats.counts[c * 256 + s];
+        }
+    }
+    const HCTree* table[256];
+    for (int j = 0; j < k; j++) {
+        trees[j].build(freqs[j]);
+    }
+    for (int c = 0; c < 256; c++) {
+        table[c] = &trees[group[c]];
+    }
+
+    // Write the group count, the map (two contexts per byte) and trees.
+    BitWriter bits(out);
+    bits.write<unsigned char>(k);
+    for (int c = 0; c < 256; c += 2) {
+        bits.write<unsigned char>(group[c] | group[c + 1] << 4);
+    }
+    for (int j = 0; j < k; j++) {
+        trees[j].serialize(bits);
+    }
+
+    // Code every byte with the tree of the byte before it.
+    unsigned char prev = 0;
+    for (size_t i = 0; i < size; i++) {
+        table[prev]->encode(data[i], bits);
+        prev = data[i];
+    }
+    bits.flush();
+    return true;
+}
+
+void decodeOrder1(const unsigned char* payload, size_t payloadSize,
+                  unsigned char* out, size_t size) {
+    BitReader bits(payload, payloadSize);
+
+    int k = bits.read<unsigned char>();
+    if (k < 1 || k > MAX_CLUSTERS) {
+        error("Corrupt block payload");
+    }
+
+    unsigned char group[256];
+    for (int c = 0; c < 256; c += 2) {
+        unsigned char pair = bits.read<unsigned char>();
+        group[c] = pair & 0xF;
+        group[c + 1] = pair >> 4;
+        if (group[c] >= k || group[c + 1] >= k) {
+            error("Corrupt block payload");
+        }
+    }
+
+    HCTree* trees = threadTrees();
+    for (int j = 0; j < k; j++) {
+        bits.read<int>();
+        trees[j].deserialize(MAX_TREE_NODES, bits);
+        if (!bits.good()) {
+            error("Corrupt block payload");
+        }
+    }
+    const HCTree* table[256];
+    for (int c = 0; c < 256; c++) {
+        table[c] = &trees[group[c]];
+    }
+
+    // The previous byte picks the tree: one load per symbol.
+    unsigned char prev = 0;
+    for (size_t i = 0; i < size; i++) {
+        prev = table[prev]->decode(bits);
+        out[i] = prev;
+    }
+
+    if (!bits.good()) {
+        error("Corrupt block payload");
+    }
+}
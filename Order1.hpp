@@ -0,0 +1,56 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides order-1 coding for the block format. Every byte is
+ * coded with a Huffman tree chosen by the byte before it (its context).
+ * One tree per context would cost more in headers than it saves, so the
+ * 256 contexts are clustered (k-means on the coded size) into at most
+ * MAX_CLUSTERS groups that share a tree. The payload of a METHOD_ORDER1
+ * block is:
+ *
+ *   cluster count (1 byte)
+ *   context -> cluster map (256 nibbles, 128 bytes)
+ *   one serialized tree per cluster
+ *   bitstream
+ *
+ * Both coders keep a 256-entry table of tree pointers indexed by the
+ * previous byte, so switching tables costs one load per symbol.
+ */
+
+#ifndef ORDER1_HPP
+#define ORDER1_HPP
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// Most trees an order-1 block can have (the map stores nibbles).
+const int MAX_CLUSTERS = 16;
+
+/**
+ * Code a block with order-1 contexts, if the estimate says that clusters
+ * beat a single tree.
+ *
+ * @param data the raw bytes
+ * @param size how many bytes
+ * @param out the payload is appended here
+ * @return false (and nothing appended) if order-0 coding is as good
+ */
+bool encodeOrder1(const unsigned char* data, size_t size,
+                  vector<unsigned char>& out);
+
+/**
+ * Decode an order-1 payload.
+ *
+ * @param payload the payload bytes
+ * @param payloadSize how many payload bytes
+ * @param out where to store the decoded bytes
+ * @param size how many bytes to decode
+ */
+void decodeOrder1(const unsigned char* payload, size_t payloadSize,
+                  unsigned char* out, size_t size);
+
+#endif // ORDER1_HPP
@@ -0,0 +1,202 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides the implementation of parallel decoding through
+ * self-synchronization.
+ */
+
+#include "ParallelDecode.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Smallest chunk handed to a worker, in bits.
+static const uint64_t MIN_CHUNK_BITS = (uint64_t)1 << 23;
+
+// Chunks per worker, so a slow chunk does not hold up the others.
+static const size_t CHUNKS_PER_THREAD = 4;
+
+// Symbol boundaries remembered at the start of each chunk. Decoders
+// usually synchronize within a few dozen symbols; if they have not by
+// then (e.g. every code has the same length), the chunk is decoded again
+// from its true start.
+static const size_t SYNC_WINDOW = 4096;
+
+/**
+ * A BitReader that starts at any bit of a buffer and reports positions
+ * relative to the start of the buffer.
+ */
+struct PositionedReader {
+    BitReader bits;
+    uint64_t base; // position of the first bit the reader was given
+
+    PositionedReader(const unsigned char* data, size_t size, uint64_t bit)
+        : bits(data + min<uint64_t>(bit / 8, size),
+               size - min<uint64_t>(bit / 8, size)),
+          base(min<uint64_t>(bit / 8, size) * 8) {
+        int extra = bit % 8;
+        if (extra != 0) {
+            bits.peek(extra);
+            bits.skip(extra);
+        }
+    }
+
+    /**
+     * @return the bit position of the reader in the buffer
+     */
+    uint64_t position() const { return base + bits.position(); }
+};
+
+/**
+ * One chunk of the bitstream.
+ */
+struct Chunk {
+    uint64_t startBit; // the bits this chunk was given
+    uint64_t endBit;
+
+    // Decoded speculatively from startBit: the symbols that start before
+    // endBit, the position before each of the first of them, and the
+    // position after the last one.
+    vector<unsigned char> symbols;
+    vector<uint64_t> boundaries;
+    uint64_t specEnd;
+
+    // Filled in by the sequential pass: the true symbols in front of the
+    // point where the decoders meet, and how many speculative symbols
+    // they replace.
+    vector<unsigned char> head;
+    size_t skip;
+    size_t offset; // where the chunk goes in the output
+};
+
+/**
+ * Decode a chunk from its start bit, which may not be a true boundary.
+ */
+static void decodeSpeculative(const HCTree& tree, const unsigned char* data,
+                              size_t size, Chunk& chunk) {
+    PositionedReader in(data, size, chunk.startBit);
+
+    // Start with room for two symbols per byte and grow as needed.
+    chunk.symbols.resize((chunk.endBit - chunk.startBit) / 4);
+    chunk.boundaries.reserve(SYNC_WINDOW);
+
+    size_t n = 0;
+    uint64_t pos = chunk.startBit;
+    while (pos < chunk.endBit) {
+        if (n < SYNC_WINDOW) {
+            chunk.boundaries.push_back(pos);
+        }
+        if (n == chunk.symbols.size()) {
+            chunk.symbols.resize(2 * n + 1);
+        }
+        chunk.symbols[n++] = tree.decode(in.bits);
+        pos = in.position();
+    }
+    chunk.symbols.resize(n);
+    chunk.specEnd = pos;
+}
+
+/**
+ * Starting from the true start of a chunk, decode until the speculative
+ * decoder is met.
+ *
+ * @param trueStart the true end of the previous chunk
+ * @return the true end of this chunk
+ */
+static uint64_t synchronize(const HCTree& tree, const unsigned char* data,
+                            size_t size, uint64_t trueStart, Chunk& chunk) {
+    PositionedReader in(data, size, trueStart);
+    uint64_t pos = trueStart;
+    size_t k = 0;
+
+    while (pos < chunk.endBit) {
+        // Both lists of boundaries are sorted, so walk them together.
+        while (k < chunk.boundaries.size() && chunk.boundaries[k] < pos) {
+            k++;
+        }
+        if (k < chunk.boundaries.size() && chunk.boundaries[k] == pos) {
+            chunk.skip = k;
+            return chunk.specEnd;
+        }
+        chunk.head.push_back(tree.decode(in.bits));
+        pos = in.position();
+    }
+
+    // Never met: the true symbols replace the whole chunk.
+    chunk.skip = chunk.symbols.size();
+    return pos;
+}
+
+bool parallelDecode(const HCTree& tree, const unsigned char* data,
+                    size_t size, uint64_t startBit, unsigned char* out,
+                    size_t count, ThreadPool& pool) {
+    uint64_t endBit = (uint64_t)size * 8;
+
+    // Split the stream into chunks of at least MIN_CHUNK_BITS (one chunk,
+    // i.e. the plain sequential decoder, for a single worker).
+    size_t chunkCount = pool.size() > 1 ? pool.size() * CHUNKS_PER_THREAD : 1;
+    if (startBit < endBit) {
+        chunkCount = min<uint64_t>(chunkCount,
+                                   (endBit - startBit) / MIN_CHUNK_BITS);
+    }
+    if (tree.singleSymbol() || chunkCount <= 1) {
+        PositionedReader in(data, size, startBit);
+        tree.decodeBlock(in.bits, out, count);
+        return count == 0 || in.bits.good();
+    }
+
+    vector<Chunk> chunks(chunkCount);
+    uint64_t chunkBits = (endBit - startBit) / chunkCount;
+    for (size_t i = 0; i < chunkCount; i++) {
+        chunks[i].startBit = startBit + i * chunkBits;
+        chunks[i].endBit = i + 1 < chunkCount ? chunks[i].startBit + chunkBits
+                                              : endBit;
+    }
+
+    // Decode every chunk speculatively.
+    pool.run(chunkCount, [&](int, size_t i) {
+        decodeSpeculative(tree, data, size, chunks[i]);
+    });
+
+    // Stitch: the first chunk starts at a true boundary, and each later
+    // one starts where the previous one truly ends.
+    chunks[0].skip = 0;
+    uint64_t trueEnd = chunks[0].specEnd;
+    size_t offset = 0;
+    for (size_t i = 0; i < chunkCount; i++) {
+        Chunk& chunk = chunks[i];
+        if (i > 0) {
+            trueEnd = synchronize(tree, data, size, trueEnd, chunk);
+        }
+        chunk.offset = offset;
+        offset += chunk.head.size() + chunk.symbols.size() - chunk.skip;
+    }
+
+    // Copy the chunks to the output, dropping whatever decodes past the
+    // count (the padding of the last byte).
+    pool.run(chunkCount, [&](int, size_t i) {
+        Chunk& chunk = chunks[i];
+        size_t pos = chunk.offset;
+        if (pos >= count) {
+            return;
+        }
+        size_t n = min(chunk.head.size(), count - pos);
+        if (n > 0) {
+            memcpy(out + pos, chunk.head.data(), n);
+            pos += n;
+        }
+        n = min(chunk.symbols.size() - chunk.skip, count - pos);
+        if (n > 0) {
+            memcpy(out + pos, chunk.symbols.data() + chunk.skip, n);
+        }
+    });
+
+    // The true symbols run until the first one that ends at or past the
+    // end of the data, and the count must be covered without that one
+    // going past it.
+    return offset > count || (offset == count && trueEnd <= endBit);
+}
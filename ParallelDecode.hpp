@@ -0,0 +1,47 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides parallel decoding of a single-stream bitstream. The
+ * stream has no symbol boundaries, so it is cut into chunks at arbitrary
+ * bit positions and every chunk is decoded speculatively on its own.
+ * Huffman codes are self-synchronizing: a decoder that starts in the
+ * middle of a code soon lands on a true symbol boundary, and from there
+ * on it decodes the true symbols. A sequential pass then starts from the
+ * true end of each chunk and decodes the next chunk's first symbols
+ * until it meets a boundary the speculative decoder also visited; only
+ * the symbols before that point are replaced. Finally the chunks are
+ * copied to their place in the output.
+ */
+
+#ifndef PARALLELDECODE_HPP
+#define PARALLELDECODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "HCTree.hpp"
+#include "ThreadPool.hpp"
+
+// Inputs smaller than this are not worth splitting.
+const size_t PARALLEL_MIN_SIZE = 4 << 20;
+
+/**
+ * Decode count symbols of a bitstream in memory on a thread pool. The
+ * result is the same as tree.decodeBlock() from startBit.
+ *
+ * @param tree the Huffman tree, already deserialized
+ * @param data the whole compressed file
+ * @param size its size in bytes
+ * @param startBit where the bitstream starts in data
+ * @param out where to store the decoded symbols
+ * @param count how many symbols to decode
+ * @param pool the workers
+ * @return false if the bitstream ends before count symbols (corrupt input)
+ */
+bool parallelDecode(const HCTree& tree, const unsigned char* data,
+                    size_t size, uint64_t startBit, unsigned char* out,
+                    size_t count, ThreadPool& pool);
+
+#endif // PARALLELDECODE_HPP
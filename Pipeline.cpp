@@ -0,0 +1,483 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: io_uring(7) man page.
+ *
+ * This file provides the implementation of the reader -> coding stage ->
+ * writer block pipeline.
+ */
+
+#include "Pipeline.hpp"
+#include "Uring.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const size_t BlockPipeline::DEFAULT_BLOCK_SIZE = 1 << 20;
+const size_t BlockPipeline::DEFAULT_DEPTH = 4;
+
+/**
+ * Positional I/O (and so io_uring) only works on regular files; pipes,
+ * terminals and sockets are read/written sequentially.
+ *
+ * @param fd the file descriptor
+ * @return true if fd refers to a regular file
+ */
+static bool isRegular(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/**
+ * Read until buf is full or the input ends.
+ *
+ * @param fd file descriptor
+ * @param buf where to read to
+ * @param len how many bytes to read
+ * @param offset file offset, or -1 to read sequentially
+ * @return the number of bytes read
+ */
+static size_t readFully(int fd, unsigned char* buf, size_t len,
+                        off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = (offset < 0) ? read(fd, buf + done, len - done)
+                                 : pread(fd, buf + done, len - done,
+                                         offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error("Read failed: " + string(strerror(errno)));
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * Write all of buf.
+ *
+ * @param fd file descriptor
+ * @param buf what to write
+ * @param len how many bytes to write
+ * @param offset file offset, or -1 to write sequentially
+ */
+static void writeFully(int fd, const unsigned char* buf, size_t len,
+                       off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = (offset < 0) ? write(fd, buf + done, len - done)
+                                 : pwrite(fd, buf + done, len - done,
+                                          offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error("Write failed: " + string(strerror(errno)));
+        }
+        done += n;
+    }
+}
+
+BlockPipeline::BlockPipeline(int inFd, int outFd, size_t blockSize,
+                             size_t depth)
+    : inFd(inFd), outFd(outFd), blockBytes(blockSize),
+      depth(depth < 2 ? 2 : depth), blocks(2 * this->depth),
+      inFree(this->depth), inFull(this->depth), outFree(this->depth),
+      outFull(this->depth), stopping(false), readerFailed(false),
+      writerFailed(false), current(nullptr), inputDone(false) {
+
+    // The first half of the blocks carry input, the second half output.
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].data.resize(blockBytes);
+        blocks[i].size = 0;
+        if (i < this->depth) {
+            inFree.push(&blocks[i]);
+        } else if (outFd >= 0) {
+            outFree.push(&blocks[i]);
+        }
+    }
+}
+
+Block* BlockPipeline::take(SpscRing<Block*>& ring,
+                           const atomic<bool>* failed) {
+    Block* block;
+    if (ring.pop(block)) {
+        return block;
+    }
+
+    // Check again under the lock: a producer pushes before it takes the
+    // lock to notify, so the wakeup can not slip in between.
+    unique_lock<mutex> guard(waitLock);
+    while (!ring.pop(block)) {
+        if (stopping.load() || (failed != nullptr && failed->load())) {
+            return nullptr;
+        }
+        changed.wait(guard);
+    }
+    return block;
+}
+
+void BlockPipeline::put(SpscRing<Block*>& ring, Block* block) {
+
+    // Each ring can hold every block of its direction, so it never fills.
+    if (!ring.push(block)) {
+        error("Pipeline ring overflow");
+    }
+    lock_guard<mutex> guard(waitLock);
+    changed.notify_all();
+}
+
+void BlockPipeline::raise(atomic<bool>& flag) {
+    flag.store(true);
+    lock_guard<mutex> guard(waitLock);
+    changed.notify_all();
+}
+
+void BlockPipeline::run(const function<void(BlockPipeline&)>& stage) {
+    thread reader(&BlockPipeline::readerLoop, this);
+    thread writer;
+    if (outFd >= 0) {
+        writer = thread(&BlockPipeline::writerLoop, this);
+    }
+
+    string failure;
+    try {
+        stage(*this);
+        if (current != nullptr) {
+            releaseInput(current);
+            current = nullptr;
+        }
+
+        // An empty block tells the writer that the output is complete.
+        if (outFd >= 0) {
+            Block* last = acquireOutput();
+            last->size = 0;
+            emitOutput(last);
+            writer.join();
+        }
+    } catch (const exception& e) {
+        failure = e.what();
+    }
+
+    // The coding stage may stop before the end of the input (or fail), so
+    // the reader (and writer) may still be waiting for blocks.
+    raise(stopping);
+    reader.join();
+    if (writer.joinable()) {
+        writer.join();
+    }
+
+    if (failure.empty() && readerFailed.load()) {
+        failure = readerError;
+    }
+    if (failure.empty() && writerFailed.load()) {
+        failure = writerError;
+    }
+    if (!failure.empty()) {
+        error(failure);
+    }
+}
+
+Block* BlockPipeline::nextInput() {
+    if (inputDone) {
+        return nullptr;
+    }
+
+    // The pipeline only stops once the coding stage is done, so the wait
+    // can only end early because the reader failed.
+    Block* block = take(inFull, &readerFailed);
+    if (block == nullptr) {
+        error(readerError);
+    }
+
+    // The reader signals the end of the input with an empty block.
+    if (block->size == 0) {
+        inputDone = true;
+        put(inFree, block);
+        return nullptr;
+    }
+    return block;
+}
+
+void BlockPipeline::releaseInput(Block* block) {
+    put(inFree, block);
+}
+
+Block* BlockPipeline::acquireOutput() {
+    Block* block = take(outFree, &writerFailed);
+    if (block == nullptr) {
+        error(writerError);
+    }
+    block->size = 0;
+    return block;
+}
+
+void BlockPipeline::emitOutput(Block* block) {
+    put(outFull, block);
+}
+
+bool BlockPipeline::next(const unsigned char*& begin,
+                         const unsigned char*& end) {
+    if (current != nullptr) {
+        releaseInput(current);
+        current = nullptr;
+    }
+    current = nextInput();
+    if (current == nullptr) {
+        return false;
+    }
+    begin = current->data.data();
+    end = begin + current->size;
+    return true;
+}
+
+void BlockPipeline::readerLoop() {
+    try {
+        if (isRegular(inFd)) {
+            Uring ring(depth);
+            if (ring.ok()) {
+                readUring(ring);
+                return;
+            }
+        }
+        readPlain();
+    } catch (const exception& e) {
+        readerError = e.what();
+        raise(readerFailed);
+    }
+}
+
+/**
+ * Fill one block at a time with blocking reads.
+ */
+void BlockPipeline::readPlain() {
+    off_t offset = isRegular(inFd) ? lseek(inFd, 0, SEEK_CUR) : -1;
+
+    while (true) {
+        Block* block = take(inFree);
+        if (block == nullptr) {
+            return;
+        }
+
+        block->size = readFully(inFd, block->data.data(), blockBytes, offset);
+        if (offset >= 0) {
+            offset += block->size;
+        }
+
+        // An empty block marks the end of the input.
+        put(inFull, block);
+        if (block->size == 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * Keep a read in flight for every free input block, and hand the blocks to
+ * the coding stage in file order as they complete.
+ */
+void BlockPipeline::readUring(Uring& ring) {
+    deque<Block*> inflight;
+    uint64_t offset = lseek(inFd, 0, SEEK_CUR);
+    bool eof = false;
+
+    // Blocks this thread recycled itself. The coding stage is the only
+    // producer of inFree, so they are kept here and used first.
+    deque<Block*> spare;
+    auto takeFree = [&](Block*& block) {
+        if (!spare.empty()) {
+            block = spare.front();
+            spare.pop_front();
+            return true;
+        }
+        return inFree.pop(block);
+    };
+
+    while (true) {
+        // Queue reads for all the free blocks we have.
+        Block* block;
+        while (!eof && !stopping.load() && inflight.size() < depth &&
+               takeFree(block)) {
+            block->offset = offset;
+            block->done = false;
+            ring.read(inFd, block->data.data(), blockBytes, offset,
+                      (uint64_t)(uintptr_t)block);
+            offset += blockBytes;
+            inflight.push_back(block);
+        }
+        ring.submit();
+
+        if (inflight.empty()) {
+            if (eof || stopping.load()) {
+                break;
+            }
+
+            // Nothing to read into: sleep until the coding stage frees a
+            // block.
+            block = take(inFree);
+            if (block == nullptr) {
+                break;
+            }
+            spare.push_back(block);
+            continue;
+        }
+
+        uint64_t userData;
+        int result = ring.wait(userData);
+        Block* finished = (Block*)(uintptr_t)userData;
+        finished->result = result;
+        finished->done = true;
+
+        // Deliver the completed blocks at the front, in file order.
+        while (!inflight.empty() && inflight.front()->done) {
+            block = inflight.front();
+            inflight.pop_front();
+
+            // Reads queued past the end of the file are just recycled.
+            if (eof || stopping.load()) {
+                spare.push_back(block);
+                continue;
+            }
+
+            // Short (or failed) reads are finished with plain preads.
+            size_t got = block->result > 0 ? block->result : 0;
+            if (got < blockBytes) {
+                got += readFully(inFd, block->data.data() + got,
+                                 blockBytes - got, block->offset + got);
+            }
+            block->size = got;
+
+            if (got < blockBytes) {
+                eof = true;
+            }
+            if (got > 0) {
+                put(inFull, block);
+            } else {
+                spare.push_back(block);
+            }
+        }
+    }
+
+    if (stopping.load()) {
+        return;
+    }
+
+    // An empty block marks the end of the input.
+    Block* last;
+    if (!takeFree(last)) {
+        last = take(inFree);
+    }
+    if (last != nullptr) {
+        last->size = 0;
+        put(inFull, last);
+    }
+}
+
+void BlockPipeline::writerLoop() {
+    try {
+        if (isRegular(outFd)) {
+            Uring ring(depth);
+            if (ring.ok()) {
+                writeUring(ring);
+                return;
+            }
+        }
+        writePlain();
+    } catch (const exception& e) {
+        writerError = e.what();
+        raise(writerFailed);
+    }
+}
+
+/**
+ * Write one block at a time with blocking writes.
+ */
+void BlockPipeline::writePlain() {
+    off_t offset = isRegular(outFd) ? 0 : -1;
+
+    while (true) {
+        Block* block = take(outFull);
+        if (block == nullptr) {
+            return;
+        }
+
+        // An empty block marks the end of the output.
+        if (block->size == 0) {
+            put(outFree, block);
+            return;
+        }
+
+        writeFully(outFd, block->data.data(), block->size, offset);
+        if (offset >= 0) {
+            offset += block->size;
+        }
+        put(outFree, block);
+    }
+}
+
+/**
+ * Keep a write in flight for every filled output block, recycling blocks
+ * as their writes complete.
+ */
+void BlockPipeline::writeUring(Uring& ring) {
+    size_t inflight = 0;
+    uint64_t offset = 0;
+    bool finished = false;
+
+    while (!finished || inflight > 0) {
+        Block* block = nullptr;
+        if (!finished && inflight < depth) {
+            // With no write in flight there is nothing else to wait for,
+            // so sleep until the coding stage emits a block.
+            if (inflight == 0) {
+                block = take(outFull);
+                if (block == nullptr) {
+                    return;
+                }
+            } else if (!outFull.pop(block)) {
+                block = nullptr;
+            }
+        }
+
+        if (block != nullptr) {
+            // An empty block marks the end of the output.
+            if (block->size == 0) {
+                finished = true;
+                put(outFree, block);
+                continue;
+            }
+
+            block->offset = offset;
+            offset += block->size;
+            ring.write(outFd, block->data.data(), block->size,
+                       block->offset, (uint64_t)(uintptr_t)block);
+            ring.submit();
+            inflight++;
+            continue;
+        }
+
+        // Here a write is in flight; wait for one to complete.
+        uint64_t userData;
+        int result = ring.wait(userData);
+        block = (Block*)(uintptr_t)userData;
+
+        // Short (or failed) writes are finished with plain pwrites.
+        size_t written = result > 0 ? result : 0;
+        if (written < block->size) {
+            writeFully(outFd, block->data.data() + written,
+                       block->size - written, block->offset + written);
+        }
+        put(outFree, block);
+        inflight--;
+    }
+}
@@ -0,0 +1,230 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: io_uring(7) man page.
+ *
+ * This file provides a three stage block pipeline: a reader thread fills
+ * large input blocks, the coding stage (running on the calling thread)
+ * turns input blocks into output blocks, and a writer thread writes the
+ * output blocks out. The stages are connected by bounded lock-free
+ * single-producer/single-consumer rings, so disk I/O and coding overlap
+ * and the total time approaches max(I/O, CPU) instead of their sum. A
+ * stage that finds its ring empty sleeps on a condition variable until
+ * another stage passes it a block, instead of spinning.
+ * The reader/writer use io_uring to keep several blocks in flight when the
+ * kernel supports it, and plain blocking reads/writes otherwise.
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BitIO.hpp"
+using namespace std;
+
+class Uring;
+
+/**
+ * A bounded lock-free ring for exactly one producer and one consumer
+ * thread. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscRing {
+private:
+    vector<T> slots;
+    size_t mask;
+
+    // Consumer and producer positions (never wrap, only the slot index
+    // is masked), kept on separate cache lines.
+    alignas(64) atomic<size_t> head;
+    alignas(64) atomic<size_t> tail;
+
+public:
+    /**
+     * Constructor, which makes room for at least capacity items
+     *
+     * @param capacity minimum number of items the ring can hold
+     */
+    explicit SpscRing(size_t capacity);
+
+    /**
+     * Add an item (producer thread only).
+     *
+     * @param item the item to add
+     * @return false if the ring is full
+     */
+    bool push(const T& item);
+
+    /**
+     * Remove the oldest item (consumer thread only).
+     *
+     * @param item set to the removed item
+     * @return false if the ring is empty
+     */
+    bool pop(T& item);
+};
+
+/**
+ * A block of bytes travelling through the pipeline.
+ */
+struct Block {
+    vector<unsigned char> data; // storage, at least size bytes
+    size_t size;                // bytes in use
+    uint64_t offset;            // file offset (reader/writer bookkeeping)
+    int result;                 // io_uring completion result
+    bool done;                  // io_uring request completed
+};
+
+/**
+ * Reader -> coding stage -> writer pipeline over two file descriptors.
+ * It is also a BitSource, so a BitReader can read straight across the
+ * input blocks.
+ */
+class BlockPipeline : public BitSource {
+private:
+    int inFd;           // file to read from
+    int outFd;          // file to write to, -1 for no writer stage
+    size_t blockBytes;  // size of an input block
+    size_t depth;       // blocks per direction (and io_uring depth)
+
+    vector<Block> blocks;    // all blocks, input ones first
+    SpscRing<Block*> inFree; // coding stage -> reader: empty input blocks
+    SpscRing<Block*> inFull; // reader -> coding stage: filled input blocks
+    SpscRing<Block*> outFree;// writer -> coding stage: empty output blocks
+    SpscRing<Block*> outFull;// coding stage -> writer: filled output blocks
+
+    // Every ring has exactly one producer: blocks the reader recycles
+    // itself stay in its own list instead of going back into inFree.
+
+    // Stages sleep on changed while the ring they need is empty; every
+    // push and every stop or failure wakes them up.
+    mutex waitLock;
+    condition_variable changed;
+
+    atomic<bool> stopping;    // ask the reader/writer threads to exit
+    atomic<bool> readerFailed;
+    atomic<bool> writerFailed;
+    string readerError;
+    string writerError;
+
+    Block* current;   // input block handed out through next()
+    bool inputDone;   // the reader's end-of-file block was seen
+
+    /**
+     * Take a block from the ring, sleeping while it is empty.
+     *
+     * @param ring the ring (this thread must be its consumer)
+     * @param failed a stage whose failure also ends the wait, or nullptr
+     * @return nullptr if the pipeline is stopping or that stage failed
+     */
+    Block* take(SpscRing<Block*>& ring,
+                const atomic<bool>* failed = nullptr);
+
+    /**
+     * Add a block to a ring and wake up whoever waits for it.
+     *
+     * @param ring the ring (this thread must be its producer)
+     * @param block the block
+     */
+    void put(SpscRing<Block*>& ring, Block* block);
+
+    /**
+     * Set a flag (stopping or a failure) and wake up every waiting stage.
+     *
+     * @param flag the flag
+     */
+    void raise(atomic<bool>& flag);
+
+    /**
+     * Reader thread body (and its plain and io_uring loops).
+     */
+    void readerLoop();
+    void readPlain();
+    void readUring(Uring& ring);
+
+    /**
+     * Writer thread body (and its plain and io_uring loops).
+     */
+    void writerLoop();
+    void writePlain();
+    void writeUring(Uring& ring);
+
+public:
+    static const size_t DEFAULT_BLOCK_SIZE;
+    static const size_t DEFAULT_DEPTH;
+
+    /**
+     * Constructor, which sets up (but does not start) the pipeline.
+     * Reading starts at the current offset of inFd.
+     *
+     * @param inFd file descriptor to read the input from
+     * @param outFd file descriptor to write the output to, or -1
+     * @param blockSize size of each input block in bytes
+     * @param depth number of blocks in flight in each direction (>= 2)
+     */
+    BlockPipeline(int inFd, int outFd,
+                  size_t blockSize = DEFAULT_BLOCK_SIZE,
+                  size_t depth = DEFAULT_DEPTH);
+
+    /**
+     * Start the reader and writer threads, run the coding stage on this
+     * thread, and wait until everything it emitted has been written.
+     * Errors in any stage are reported through error().
+     *
+     * @param stage the coding stage
+     */
+    void run(const function<void(BlockPipeline&)>& stage);
+
+    /**
+     * @return the size of the input blocks
+     */
+    size_t blockSize() const { return blockBytes; }
+
+    /**
+     * Get the next filled input block, waiting for the reader if needed.
+     *
+     * @return the block, or nullptr at the end of the input
+     */
+    Block* nextInput();
+
+    /**
+     * Give a block obtained from nextInput() back to the reader.
+     *
+     * @param block the block
+     */
+    void releaseInput(Block* block);
+
+    /**
+     * Get an empty output block (size 0, data of at least blockSize()
+     * bytes), waiting for the writer if needed.
+     *
+     * @return the block
+     */
+    Block* acquireOutput();
+
+    /**
+     * Queue an output block for writing. Its first size bytes are written.
+     *
+     * @param block the block
+     */
+    void emitOutput(Block* block);
+
+    /**
+     * BitSource: release the current input block and move to the next.
+     */
+    bool next(const unsigned char*& begin,
+              const unsigned char*& end) override;
+};
+
+#include "Pipeline.tcc"
+
+#endif // PIPELINE_HPP
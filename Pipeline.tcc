@@ -0,0 +1,47 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the template implementations for SpscRing.
+ */
+
+
+template<typename T>
+SpscRing<T>::SpscRing(size_t capacity) : head(0), tail(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots.resize(size);
+    mask = size - 1;
+}
+
+template<typename T>
+bool SpscRing<T>::push(const T& item) {
+    size_t t = tail.load(memory_order_relaxed);
+
+    // Full when the producer is a whole lap ahead of the consumer.
+    if (t - head.load(memory_order_acquire) > mask) {
+        return false;
+    }
+    slots[t & mask] = item;
+
+    // Publish the slot before the consumer can see the new tail.
+    tail.store(t + 1, memory_order_release);
+    return true;
+}
+
+template<typename T>
+bool SpscRing<T>::pop(T& item) {
+    size_t h = head.load(memory_order_relaxed);
+    if (h == tail.load(memory_order_acquire)) {
+        return false;
+    }
+    item = slots[h & mask];
+
+    // Hand the slot back to the producer.
+    head.store(h + 1, memory_order_release);
+    return true;
+}
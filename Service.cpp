@@ -0,0 +1,308 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: unix(7), memfd_create(2), cmsg(3) and poll(2) man pages.
+ *
+ * This file provides the implementation of the service message protocol.
+ */
+
+#include "Service.hpp"
+#include "BitIO.hpp"
+#include "Codec.hpp"
+#include "Helper.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Inline data is read into a buffer grown by at most this much at a time,
+// so a header alone does not make the receiver allocate its whole size.
+static const size_t RECEIVE_STEP = 4 << 20;
+
+/**
+ * @param timeoutSeconds the timeout, or 0 for none
+ * @return when a message started now has to be done by
+ */
+static Deadline deadlineAfter(int timeoutSeconds) {
+    if (timeoutSeconds <= 0) {
+        return Deadline::max();
+    }
+    return chrono::steady_clock::now() + chrono::seconds(timeoutSeconds);
+}
+
+/**
+ * Wait until a socket is ready, or its deadline passes.
+ *
+ * @param sock the socket
+ * @param events POLLIN or POLLOUT
+ * @param deadline when to give up (Deadline::max() never does)
+ * @return false if the deadline passed first
+ */
+static bool waitSocket(int sock, short events, Deadline deadline) {
+    while (true) {
+        int timeout = -1;
+        if (deadline != Deadline::max()) {
+            long long left = chrono::duration_cast<chrono::milliseconds>(
+                deadline - chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                return false;
+            }
+            timeout = (int)min<long long>(left, INT_MAX);
+        }
+        pollfd fd = {sock, events, 0};
+        int n = poll(&fd, 1, timeout);
+
+        // Errors and hang-ups are left to the read or write to report.
+        if (n > 0 || (n < 0 && errno != EINTR)) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @return true if a failed socket call should just be retried
+ */
+static bool retryable() {
+    return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+/**
+ * Read exactly size bytes from a socket.
+ *
+ * @param deadline when to give up (and throw)
+ * @return false if the socket closed first
+ */
+static bool readSocket(int sock, unsigned char* buf, size_t size,
+                       Deadline deadline) {
+    size_t done = 0;
+    while (done < size) {
+        if (!waitSocket(sock, POLLIN, deadline)) {
+            error("Message timed out");
+        }
+        ssize_t n = recv(sock, buf + done, size - done, MSG_DONTWAIT);
+        if (n < 0 && retryable()) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+/**
+ * Write exactly size bytes to a socket.
+ *
+ * @param deadline when to give up
+ * @return false if the peer has gone away or stopped reading
+ */
+static bool writeSocket(int sock, const unsigned char* buf, size_t size,
+                        Deadline deadline) {
+    size_t done = 0;
+    while (done < size) {
+        if (!waitSocket(sock, POLLOUT, deadline)) {
+            return false;
+        }
+        ssize_t n = send(sock, buf + done, size - done,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && retryable()) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool sendMessage(int sock, unsigned char code, const unsigned char* data,
+                 size_t size, bool useFd, int timeoutSeconds) {
+    Deadline deadline = deadlineAfter(timeoutSeconds);
+    vector<unsigned char> header;
+    BitWriter bits(header);
+    bits.write<uint32_t>(SERVICE_MAGIC);
+    bits.write<unsigned char>(code);
+    bits.write<unsigned char>(useFd ? MESSAGE_FD : 0);
+    bits.write<uint16_t>(0);
+    bits.write<uint64_t>(size);
+
+    if (!useFd) {
+        return writeSocket(sock, header.data(), header.size(), deadline) &&
+               writeSocket(sock, data, size, deadline);
+    }
+
+    // Put the data in a memfd, seal it so the receiver can map it
+    // safely, and pass it with the header.
+    int fd = memfd_create("huffd", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        error("Cannot create shared buffer: " + string(strerror(errno)));
+    }
+    try {
+        writeFully(fd, data, size);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    if (fcntl(fd, F_ADD_SEALS,
+              F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        close(fd);
+        error("Cannot seal shared buffer: " + string(strerror(errno)));
+    }
+
+    iovec iov = {header.data(), header.size()};
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    ssize_t n = -1;
+    while (waitSocket(sock, POLLOUT, deadline)) {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n >= 0 || !retryable()) {
+            break;
+        }
+    }
+    close(fd);
+
+    // The fd went with the first byte; the rest of the header may not.
+    return n > 0 && writeSocket(sock, header.data() + n, header.size() - n,
+                                deadline);
+}
+
+bool receiveMessage(int sock, ServiceMessage& msg,
+                    vector<unsigned char>& data, int timeoutSeconds) {
+    Deadline deadline = deadlineAfter(timeoutSeconds);
+    unsigned char header[MESSAGE_HEADER_SIZE];
+    iovec iov = {header, sizeof(header)};
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        if (!waitSocket(sock, POLLIN, deadline)) {
+            error("Message timed out");
+        }
+        n = recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while (n < 0 && retryable());
+    if (n <= 0) {
+        return false;
+    }
+
+    msg.fd = -1;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&msg.fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if (!readSocket(sock, header + n, sizeof(header) - n, deadline)) {
+        error("Truncated message");
+    }
+    BitReader bits(header, sizeof(header));
+    uint32_t magic = bits.read<uint32_t>();
+    msg.code = bits.read<unsigned char>();
+    msg.flags = bits.read<unsigned char>();
+    bits.read<uint16_t>();
+    msg.size = bits.read<uint64_t>();
+    if (magic != SERVICE_MAGIC) {
+        error("Corrupt message");
+    }
+
+    // Passed data is checked when it is mapped (mapSharedBuffer), so a
+    // bad buffer gets an error reply instead of dropping the connection.
+    if (msg.flags & MESSAGE_FD) {
+        if (msg.fd < 0) {
+            error("Corrupt message");
+        }
+        return true;
+    }
+
+    if (msg.fd >= 0) {
+        close(msg.fd);
+        msg.fd = -1;
+    }
+    if (msg.size > MAX_INLINE_SIZE) {
+        error("Message too large");
+    }
+
+    // Grow the buffer as the data arrives (doubling, so the reads stay
+    // linear in the size).
+    data.clear();
+    while (data.size() < msg.size) {
+        size_t done = data.size();
+        size_t step = min<uint64_t>(msg.size - done, RECEIVE_STEP);
+        if (data.capacity() < done + step) {
+            data.reserve(max(done + step, 2 * data.capacity()));
+        }
+        data.resize(done + step);
+        if (!readSocket(sock, data.data() + done, step, deadline)) {
+            error("Truncated message");
+        }
+    }
+    return true;
+}
+
+MappedFile* mapSharedBuffer(const ServiceMessage& msg) {
+
+    // Mapping past the end of the memfd, or a memfd the sender can still
+    // shrink, would crash the receiver with SIGBUS.
+    const int required = F_SEAL_SHRINK | F_SEAL_WRITE;
+    int seals = fcntl(msg.fd, F_GET_SEALS);
+    struct stat fdStat;
+    if (seals < 0 || (seals & required) != required) {
+        error("Shared buffer is not sealed");
+    }
+    if (fstat(msg.fd, &fdStat) != 0 || (uint64_t)fdStat.st_size < msg.size) {
+        error("Shared buffer is too small");
+    }
+    return new MappedFile(msg.fd, msg.size, false);
+}
+
+FdGuard::~FdGuard() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+int connectService(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error("Socket path too long");
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        error("Cannot connect to " + path + ": " + strerror(errno));
+    }
+    return sock;
+}
@@ -0,0 +1,151 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: unix(7), memfd_create(2) and cmsg(3) man pages.
+ *
+ * This file provides the message protocol of the compression service
+ * (huffd) on its Unix domain socket. A client sends a request and reads
+ * the reply, any number of times on one connection. Every message is a
+ * 16 byte header:
+ *
+ *   magic (4 bytes), code (1), flags (1), reserved (2), data size (8)
+ *
+ * For a request the code is the operation, for a reply the status. The
+ * data either follows the header on the socket, or, with MESSAGE_FD, is
+ * the contents of a memfd passed along with the header (SCM_RIGHTS), so
+ * large buffers are shared instead of copied through the socket. A reply
+ * uses the same way as its request. A passed memfd must be sealed against
+ * shrinking and writing, so the receiver's mapping can not be pulled out
+ * from under it.
+ */
+
+#ifndef SERVICE_HPP
+#define SERVICE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+class MappedFile;
+
+// When a message has to be sent or received by.
+typedef chrono::steady_clock::time_point Deadline;
+
+// First four bytes of every message.
+const uint32_t SERVICE_MAGIC = 0x48554644;
+
+// Size of a message header.
+const size_t MESSAGE_HEADER_SIZE = 16;
+
+// Largest data a message may carry inline.
+const uint64_t MAX_INLINE_SIZE = 1 << 30;
+
+// Largest output a decompress request may produce, so a tiny request
+// can not make the service allocate gigabytes.
+const uint64_t MAX_DECOMPRESSED_SIZE = 256 << 20;
+
+// Message flags.
+const unsigned char MESSAGE_FD = 1; // the data is in the passed memfd
+
+/**
+ * Request operations.
+ */
+enum ServiceOp {
+    OP_COMPRESS = 1,   // data is raw; reply is the block format
+    OP_DECOMPRESS = 2, // data is compressed; reply is raw
+    OP_STATS = 3       // no data; reply is the service metrics as text
+};
+
+/**
+ * Reply statuses.
+ */
+enum ServiceStatus {
+    STATUS_OK = 0,
+    STATUS_ERROR = 1 // data is the error message
+};
+
+/**
+ * A received message.
+ */
+struct ServiceMessage {
+    unsigned char code;  // the operation, or the status
+    unsigned char flags;
+    uint64_t size;       // size of the data
+    int fd;              // the passed memfd (MESSAGE_FD), or -1
+};
+
+/**
+ * Send a message.
+ *
+ * @param sock the connected socket
+ * @param code the operation or status
+ * @param data the data
+ * @param size its size
+ * @param useFd true to pass the data in a memfd
+ * @param timeoutSeconds how long the whole message may take (0 for no
+ *                       limit)
+ * @return false if the peer has gone away or did not take the message in
+ *         time
+ */
+bool sendMessage(int sock, unsigned char code, const unsigned char* data,
+                 size_t size, bool useFd, int timeoutSeconds = 0);
+
+/**
+ * Receive a message. Inline data is read into data; passed data is left
+ * in msg.fd for the caller to map (see mapSharedBuffer) and close.
+ *
+ * @param sock the connected socket
+ * @param msg set to the message header
+ * @param data set to the inline data (its memory is reused)
+ * @param timeoutSeconds how long the whole message may take once this is
+ *                       called (0 for no limit); a message that takes
+ *                       longer throws, however steadily its bytes arrive
+ * @return false if the peer closed the connection before a message
+ */
+bool receiveMessage(int sock, ServiceMessage& msg,
+                    vector<unsigned char>& data, int timeoutSeconds = 0);
+
+/**
+ * Map the memfd passed with a message, after checking that it is sealed
+ * against shrinking and writing and holds msg.size bytes.
+ *
+ * @param msg the message (with MESSAGE_FD)
+ * @return the mapping, to delete after use
+ */
+MappedFile* mapSharedBuffer(const ServiceMessage& msg);
+
+/**
+ * Closes a file descriptor when it goes out of scope.
+ */
+class FdGuard {
+private:
+    int fd;
+
+public:
+    /**
+     * @param fd the file descriptor, or -1 for none
+     */
+    explicit FdGuard(int fd) : fd(fd) {}
+
+    /**
+     * Destructor, which closes the file descriptor
+     */
+    ~FdGuard();
+
+    FdGuard(const FdGuard&) = delete;
+    FdGuard& operator=(const FdGuard&) = delete;
+};
+
+/**
+ * Connect to the service.
+ *
+ * @param path the socket path
+ * @return the connected socket
+ */
+int connectService(const string& path);
+
+#endif // SERVICE_HPP
@@ -0,0 +1,95 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the implementation of the thread pool.
+ */
+
+#include "ThreadPool.hpp"
+#include "Helper.hpp"
+
+#include <exception>
+
+ThreadPool::ThreadPool(size_t threads)
+    : itemCount(0), nextItem(0), batch(0), busy(0), shuttingDown(false) {
+    if (threads == 0) {
+        threads = thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.push_back(thread(&ThreadPool::workerLoop, this, (int)i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        shuttingDown = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
+
+void ThreadPool::workerLoop(int id) {
+    size_t seen = 0;
+    while (true) {
+        // Sleep until there is a new batch.
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&]() { return shuttingDown || batch != seen; });
+            if (shuttingDown) {
+                return;
+            }
+            seen = batch;
+        }
+
+        // Take items until the batch runs out.
+        size_t item;
+        while ((item = nextItem++) < itemCount) {
+            try {
+                task(id, item);
+            } catch (const exception& e) {
+                // Remember the first error and skip the remaining items.
+                lock_guard<mutex> guard(lock);
+                if (failure.empty()) {
+                    failure = e.what();
+                }
+                nextItem = itemCount;
+            }
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            if (--busy == 0) {
+                finished.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::run(size_t count, const function<void(int, size_t)>& work) {
+    {
+        lock_guard<mutex> guard(lock);
+        task = work;
+        itemCount = count;
+        nextItem = 0;
+        busy = workers.size();
+        failure.clear();
+        batch++;
+    }
+    wake.notify_all();
+
+    {
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&]() { return busy == 0; });
+    }
+    if (!failure.empty()) {
+        error(failure);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides a small fixed-size thread pool. Work is handed out
+ * as item numbers 0..count-1 from a shared counter, and every call gets
+ * the number of the worker running it, so callers can keep per-worker
+ * state (buffers, trees, ...) that is reused across items.
+ */
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * A pool of worker threads that run batches of numbered items.
+ */
+class ThreadPool {
+private:
+    vector<thread> workers;
+
+    // The current batch.
+    function<void(int, size_t)> task;
+    size_t itemCount;
+    atomic<size_t> nextItem;
+
+    // Batch bookkeeping, protected by lock.
+    mutex lock;
+    condition_variable wake;     // a new batch (or shutdown) is ready
+    condition_variable finished; // all workers are done with the batch
+    size_t batch;                // number of the current batch
+    size_t busy;                 // workers still running the batch
+    bool shuttingDown;
+    string failure;              // first error of the batch
+
+    /**
+     * Worker thread body.
+     *
+     * @param id the number of this worker
+     */
+    void workerLoop(int id);
+
+public:
+    /**
+     * Constructor, which starts the worker threads
+     *
+     * @param threads number of workers, 0 for one per CPU
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * Destructor, which stops the worker threads
+     */
+    ~ThreadPool();
+
+    /**
+     * @return the number of worker threads
+     */
+    size_t size() const { return workers.size(); }
+
+    /**
+     * Run work(worker, item) for every item in 0..count-1 on the workers
+     * and wait for all of them. Errors are reported through error().
+     *
+     * @param count the number of items
+     * @param work the work for one item
+     */
+    void run(size_t count, const function<void(int, size_t)>& work);
+};
+
+#endif // THREADPOOL_HPP
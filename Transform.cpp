@@ -0,0 +1,466 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Intel SSE2 intrinsics reference.
+ *
+ * This file provides the implementation of the block transforms. Every
+ * transform has an SSE2 path for 16 bytes at a time and a plain loop for
+ * what is left over (and for other CPUs).
+ */
+
+#include "Transform.hpp"
+#include "Helper.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#endif
+
+// Bytes of a block the auto mode tries the transforms on: TRIAL_WINDOWS
+// windows of TRIAL_WINDOW bytes, spread over the block.
+static const size_t TRIAL_WINDOWS = 16;
+static const size_t TRIAL_WINDOW = 4096;
+
+// A transform must cut the estimated size by this much to be chosen, so
+// that noise in the sample does not pick one.
+static const double TRIAL_MARGIN = 0.97;
+
+#ifdef HAVE_SSE2
+// Element-wise add and subtract of vectors, and a vector filled with one
+// element, for each element type.
+static inline __m128i addVec(__m128i a, __m128i b, uint8_t) {
+    return _mm_add_epi8(a, b);
+}
+static inline __m128i addVec(__m128i a, __m128i b, uint16_t) {
+    return _mm_add_epi16(a, b);
+}
+static inline __m128i addVec(__m128i a, __m128i b, uint32_t) {
+    return _mm_add_epi32(a, b);
+}
+static inline __m128i addVec(__m128i a, __m128i b, uint64_t) {
+    return _mm_add_epi64(a, b);
+}
+static inline __m128i subVec(__m128i a, __m128i b, uint8_t) {
+    return _mm_sub_epi8(a, b);
+}
+static inline __m128i subVec(__m128i a, __m128i b, uint16_t) {
+    return _mm_sub_epi16(a, b);
+}
+static inline __m128i subVec(__m128i a, __m128i b, uint32_t) {
+    return _mm_sub_epi32(a, b);
+}
+static inline __m128i subVec(__m128i a, __m128i b, uint64_t) {
+    return _mm_sub_epi64(a, b);
+}
+static inline __m128i fillVec(uint8_t x) { return _mm_set1_epi8(x); }
+static inline __m128i fillVec(uint16_t x) { return _mm_set1_epi16(x); }
+static inline __m128i fillVec(uint32_t x) { return _mm_set1_epi32(x); }
+static inline __m128i fillVec(uint64_t x) { return _mm_set1_epi64x(x); }
+#endif
+
+/**
+ * Delta code elements of type T: each one minus the one before it.
+ */
+template<typename T>
+static void deltaEncode(const unsigned char* in, size_t size,
+                        unsigned char* out) {
+    const size_t width = sizeof(T);
+    size_t end = size / width * width;
+    size_t pos = 0;
+
+    // The first element has nothing before it.
+    if (end > 0) {
+        memcpy(out, in, width);
+        pos = width;
+    }
+#ifdef HAVE_SSE2
+    // The vector minus the same bytes one element back.
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i cur = _mm_loadu_si128((const __m128i*)(in + pos));
+        __m128i prev = _mm_loadu_si128((const __m128i*)(in + pos - width));
+        _mm_storeu_si128((__m128i*)(out + pos), subVec(cur, prev, T()));
+    }
+#endif
+    for (; pos < end; pos += width) {
+        T cur, prev;
+        memcpy(&cur, in + pos, width);
+        memcpy(&prev, in + pos - width, width);
+        cur -= prev;
+        memcpy(out + pos, &cur, width);
+    }
+    memcpy(out + end, in + end, size - end);
+}
+
+/**
+ * Undo deltaEncode: a running sum of the elements.
+ */
+template<typename T>
+static void deltaDecode(const unsigned char* in, size_t size,
+                        unsigned char* out) {
+    const size_t width = sizeof(T);
+    size_t end = size / width * width;
+    size_t pos = 0;
+    T sum = 0;
+#ifdef HAVE_SSE2
+    // Prefix sum inside the vector by adding it to itself shifted by one,
+    // two, four... elements, then add the last sum of the vector before.
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(in + pos));
+        if (width <= 1) {
+            x = addVec(x, _mm_slli_si128(x, 1), T());
+        }
+        if (width <= 2) {
+            x = addVec(x, _mm_slli_si128(x, 2), T());
+        }
+        if (width <= 4) {
+            x = addVec(x, _mm_slli_si128(x, 4), T());
+        }
+        x = addVec(x, _mm_slli_si128(x, 8), T());
+        x = addVec(x, fillVec(sum), T());
+        _mm_storeu_si128((__m128i*)(out + pos), x);
+        memcpy(&sum, out + pos + 16 - width, width);
+    }
+#endif
+    for (; pos < end; pos += width) {
+        T cur;
+        memcpy(&cur, in + pos, width);
+        sum += cur;
+        memcpy(out + pos, &sum, width);
+    }
+    memcpy(out + end, in + end, size - end);
+}
+
+/**
+ * Find a byte in the move-to-front list.
+ *
+ * @param list the list (256 bytes, every byte once)
+ * @param c the byte
+ * @return its position
+ */
+static inline int findInList(const unsigned char* list, unsigned char c) {
+#ifdef HAVE_SSE2
+    // Compare 16 entries at once.
+    __m128i key = _mm_set1_epi8(c);
+    for (int pos = 0; ; pos += 16) {
+        __m128i entries = _mm_loadu_si128((const __m128i*)(list + pos));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(entries, key));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#else
+    int pos = 0;
+    while (list[pos] != c) {
+        pos++;
+    }
+    return pos;
+#endif
+}
+
+/**
+ * Move-to-front code: every byte becomes its position in the list, and
+ * then moves to the front of it.
+ */
+static void mtfEncode(const unsigned char* in, size_t size,
+                      unsigned char* out) {
+    unsigned char list[256];
+    for (int i = 0; i < 256; i++) {
+        list[i] = i;
+    }
+    for (size_t i = 0; i < size; i++) {
+        unsigned char c = in[i];
+        int pos = findInList(list, c);
+        out[i] = pos;
+        memmove(list + 1, list, pos);
+        list[0] = c;
+    }
+}
+
+/**
+ * Undo mtfEncode.
+ */
+static void mtfDecode(const unsigned char* in, size_t size,
+                      unsigned char* out) {
+    unsigned char list[256];
+    for (int i = 0; i < 256; i++) {
+        list[i] = i;
+    }
+    for (size_t i = 0; i < size; i++) {
+        int pos = in[i];
+        unsigned char c = list[pos];
+        out[i] = c;
+        memmove(list + 1, list, pos);
+        list[0] = c;
+    }
+}
+
+#ifdef HAVE_SSE2
+/**
+ * Split width vectors of consecutive width-byte elements into one vector
+ * per byte position: the even bytes and the odd bytes are split apart,
+ * and each half again, until single bytes are left.
+ *
+ * @param v the vectors, replaced by the planes
+ * @param width the element size (1, 2, 4 or 8)
+ */
+static void splitPlanes(__m128i* v, int width) {
+    if (width == 1) {
+        return;
+    }
+    const __m128i low = _mm_set1_epi16(0xFF);
+    __m128i even[4], odd[4];
+    for (int i = 0; i < width / 2; i++) {
+        even[i] = _mm_packus_epi16(_mm_and_si128(v[2 * i], low),
+                                   _mm_and_si128(v[2 * i + 1], low));
+        odd[i] = _mm_packus_epi16(_mm_srli_epi16(v[2 * i], 8),
+                                  _mm_srli_epi16(v[2 * i + 1], 8));
+    }
+    splitPlanes(even, width / 2);
+    splitPlanes(odd, width / 2);
+
+    // Byte 2m of an element is byte m of its even half.
+    for (int m = 0; m < width / 2; m++) {
+        v[2 * m] = even[m];
+        v[2 * m + 1] = odd[m];
+    }
+}
+
+/**
+ * Undo splitPlanes by interleaving the planes back together.
+ */
+static void mergePlanes(__m128i* v, int width) {
+    if (width == 1) {
+        return;
+    }
+    __m128i even[4], odd[4];
+    for (int m = 0; m < width / 2; m++) {
+        even[m] = v[2 * m];
+        odd[m] = v[2 * m + 1];
+    }
+    mergePlanes(even, width / 2);
+    mergePlanes(odd, width / 2);
+    for (int i = 0; i < width / 2; i++) {
+        v[2 * i] = _mm_unpacklo_epi8(even[i], odd[i]);
+        v[2 * i + 1] = _mm_unpackhi_epi8(even[i], odd[i]);
+    }
+}
+#endif
+
+/**
+ * Byte-plane transposition: byte k of element j goes to out[k * n + j].
+ */
+static void planesEncode(int width, const unsigned char* in, size_t size,
+                         unsigned char* out) {
+    size_t n = size / width;
+    size_t j = 0;
+#ifdef HAVE_SSE2
+    // Sixteen elements at a time.
+    for (; j + 16 <= n; j += 16) {
+        __m128i v[8];
+        for (int i = 0; i < width; i++) {
+            v[i] = _mm_loadu_si128((const __m128i*)(in + j * width + 16 * i));
+        }
+        splitPlanes(v, width);
+        for (int k = 0; k < width; k++) {
+            _mm_storeu_si128((__m128i*)(out + k * n + j), v[k]);
+        }
+    }
+#endif
+    for (; j < n; j++) {
+        for (int k = 0; k < width; k++) {
+            out[k * n + j] = in[j * width + k];
+        }
+    }
+    memcpy(out + n * width, in + n * width, size - n * width);
+}
+
+/**
+ * Undo planesEncode.
+ */
+static void planesDecode(int width, const unsigned char* in, size_t size,
+                         unsigned char* out) {
+    size_t n = size / width;
+    size_t j = 0;
+#ifdef HAVE_SSE2
+    for (; j + 16 <= n; j += 16) {
+        __m128i v[8];
+        for (int k = 0; k < width; k++) {
+            v[k] = _mm_loadu_si128((const __m128i*)(in + k * n + j));
+        }
+        mergePlanes(v, width);
+        for (int i = 0; i < width; i++) {
+            _mm_storeu_si128((__m128i*)(out + j * width + 16 * i), v[i]);
+        }
+    }
+#endif
+    for (; j < n; j++) {
+        for (int k = 0; k < width; k++) {
+            out[j * width + k] = in[k * n + j];
+        }
+    }
+    memcpy(out + n * width, in + n * width, size - n * width);
+}
+
+void applyTransform(int transform, const unsigned char* in, size_t size,
+                    unsigned char* out) {
+    switch (transform) {
+    case TRANSFORM_NONE:
+        memcpy(out, in, size);
+        break;
+    case TRANSFORM_DELTA1:
+        deltaEncode<uint8_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA2:
+        deltaEncode<uint16_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA4:
+        deltaEncode<uint32_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA8:
+        deltaEncode<uint64_t>(in, size, out);
+        break;
+    case TRANSFORM_MTF:
+        mtfEncode(in, size, out);
+        break;
+    case TRANSFORM_PLANES2:
+        planesEncode(2, in, size, out);
+        break;
+    case TRANSFORM_PLANES4:
+        planesEncode(4, in, size, out);
+        break;
+    case TRANSFORM_PLANES8:
+        planesEncode(8, in, size, out);
+        break;
+    default:
+        error("Unknown transform");
+    }
+}
+
+void invertTransform(int transform, const unsigned char* in, size_t size,
+                     unsigned char* out) {
+    switch (transform) {
+    case TRANSFORM_NONE:
+        memcpy(out, in, size);
+        break;
+    case TRANSFORM_DELTA1:
+        deltaDecode<uint8_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA2:
+        deltaDecode<uint16_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA4:
+        deltaDecode<uint32_t>(in, size, out);
+        break;
+    case TRANSFORM_DELTA8:
+        deltaDecode<uint64_t>(in, size, out);
+        break;
+    case TRANSFORM_MTF:
+        mtfDecode(in, size, out);
+        break;
+    case TRANSFORM_PLANES2:
+        planesDecode(2, in, size, out);
+        break;
+    case TRANSFORM_PLANES4:
+        planesDecode(4, in, size, out);
+        break;
+    case TRANSFORM_PLANES8:
+        planesDecode(8, in, size, out);
+        break;
+    default:
+        error("Unknown transform");
+    }
+}
+
+/**
+ * Estimate the coded size of bytes from their counts.
+ *
+ * @param counts how often each symbol occurs
+ * @param size how many symbols there are
+ * @param total the sum of counts
+ * @return the entropy of all the symbols, in bits
+ */
+static double entropyBits(const uint32_t* counts, size_t size,
+                          uint64_t total) {
+    double bits = 0;
+    for (size_t s = 0; s < size; s++) {
+        if (counts[s] != 0) {
+            bits += counts[s] * log2((double)total / counts[s]);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @param data the bytes
+ * @param size how many bytes
+ * @param order1 true for order-1 entropy
+ * @return the entropy of data, in bits
+ */
+static double trialEntropy(const unsigned char* data, size_t size,
+                           bool order1) {
+    if (!order1) {
+        uint32_t counts[256] = {0};
+        for (size_t i = 0; i < size; i++) {
+            counts[data[i]]++;
+        }
+        return entropyBits(counts, 256, size);
+    }
+
+    // The order-1 coder shares a tree between contexts (at most 16 of
+    // them), so the previous byte is only told apart by its high nibble.
+    uint32_t counts[16 * 256] = {0};
+    unsigned char prev = 0;
+    for (size_t i = 0; i < size; i++) {
+        counts[(prev >> 4) * 256 + data[i]]++;
+        prev = data[i];
+    }
+    double bits = 0;
+    for (int c = 0; c < 16; c++) {
+        uint64_t total = 0;
+        for (int s = 0; s < 256; s++) {
+            total += counts[c * 256 + s];
+        }
+        bits += entropyBits(&counts[c * 256], 256, total);
+    }
+    return bits;
+}
+
+int chooseTransform(const unsigned char* data, size_t size, bool order1) {
+    static thread_local vector<unsigned char> sample;
+    static thread_local vector<unsigned char> transformed;
+
+    // Take evenly spaced windows, starting at multiples of 8 so every
+    // window starts on an element for every transform.
+    sample.clear();
+    if (size <= TRIAL_WINDOWS * TRIAL_WINDOW) {
+        sample.assign(data, data + size);
+    } else {
+        size_t spacing = (size - TRIAL_WINDOW) / (TRIAL_WINDOWS - 1) / 8 * 8;
+        for (size_t w = 0; w < TRIAL_WINDOWS; w++) {
+            const unsigned char* window = data + w * spacing;
+            sample.insert(sample.end(), window, window + TRIAL_WINDOW);
+        }
+    }
+    transformed.resize(sample.size());
+
+    int best = TRANSFORM_NONE;
+    double none = trialEntropy(sample.data(), sample.size(), order1);
+    double bestBits = none * TRIAL_MARGIN;
+    for (int t = TRANSFORM_NONE + 1; t < TRANSFORM_COUNT; t++) {
+        applyTransform(t, sample.data(), sample.size(), transformed.data());
+        double bits = trialEntropy(transformed.data(), transformed.size(),
+                                   order1);
+        if (bits < bestBits) {
+            best = t;
+            bestBits = bits;
+        }
+    }
+    return best;
+}
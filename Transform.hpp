@@ -0,0 +1,83 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Intel SSE2 intrinsics reference.
+ *
+ * This file provides reversible transforms that the block format can run
+ * on a block before coding it (and undo after decoding it). Entropy
+ * coding only sees how often each byte occurs, so data whose structure
+ * lies between bytes codes badly as is:
+ *
+ *   delta    every element of 1, 2, 4 or 8 bytes (little-endian) minus
+ *            the one before it, so slowly changing numbers become small
+ *   MTF      every byte replaced by its position in a list of recently
+ *            seen bytes, so runs of a few bytes become small numbers
+ *   planes   elements of 2, 4 or 8 bytes split into one plane per byte
+ *            position, so the high bytes of numbers end up together
+ *
+ * The transform of a block is stored in its block header. Bytes that do
+ * not fill a whole element are left as they are.
+ */
+
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include <cstddef>
+
+/**
+ * The transforms, as stored in a block header.
+ */
+enum Transform {
+    TRANSFORM_NONE = 0,
+    TRANSFORM_DELTA1 = 1,
+    TRANSFORM_DELTA2 = 2,
+    TRANSFORM_DELTA4 = 3,
+    TRANSFORM_DELTA8 = 4,
+    TRANSFORM_MTF = 5,
+    TRANSFORM_PLANES2 = 6,
+    TRANSFORM_PLANES4 = 7,
+    TRANSFORM_PLANES8 = 8,
+    TRANSFORM_COUNT = 9,
+
+    // Not stored: let the encoder choose per block.
+    TRANSFORM_AUTO = 255
+};
+
+/**
+ * Transform a block.
+ *
+ * @param transform the transform (not TRANSFORM_AUTO)
+ * @param in the raw bytes
+ * @param size how many bytes
+ * @param out where to store the transformed bytes (not in)
+ */
+void applyTransform(int transform, const unsigned char* in, size_t size,
+                    unsigned char* out);
+
+/**
+ * Undo the transform of a block.
+ *
+ * @param transform the transform (not TRANSFORM_AUTO)
+ * @param in the transformed bytes
+ * @param size how many bytes
+ * @param out where to store the raw bytes (not in)
+ */
+void invertTransform(int transform, const unsigned char* in, size_t size,
+                     unsigned char* out);
+
+/**
+ * Pick the transform for a block by trial: run every transform on a
+ * sample of the block and keep the one whose output has the lowest
+ * entropy, as the coder will see it. An order-0 coder only sees how often
+ * each byte occurs, which the planes transform does not change; an
+ * order-1 coder also sees which byte comes before.
+ *
+ * @param data the raw bytes
+ * @param size how many bytes
+ * @param order1 true to measure order-1 entropy instead of order-0
+ * @return the transform (TRANSFORM_NONE unless one clearly helps)
+ */
+int chooseTransform(const unsigned char* data, size_t size, bool order1);
+
+#endif // TRANSFORM_HPP
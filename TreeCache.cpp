@@ -0,0 +1,76 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides the implementation of the tree cache.
+ */
+
+#include "TreeCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Compute the signature of a histogram: one byte per symbol, 0 if it does
+ * not occur, otherwise 1 + its -log2 probability in half bits.
+ *
+ * @param symFreq how often each byte occurs
+ * @param size the sum of symFreq
+ * @return the signature
+ */
+static string histogramSignature(const vector<int>& symFreq, size_t size) {
+    string signature(symFreq.size(), '\0');
+    for (size_t s = 0; s < symFreq.size(); s++) {
+        if (symFreq[s] != 0) {
+            double halfBits = 2 * log2((double)size / symFreq[s]);
+            signature[s] = (char)(1 + min(254, (int)halfBits));
+        }
+    }
+    return signature;
+}
+
+TreeCache::TreeCache(size_t capacity)
+    : capacity(max<size_t>(capacity, 1)), hitCount(0), missCount(0) {}
+
+shared_ptr<HCTree> TreeCache::treeFor(const vector<int>& symFreq,
+                                      size_t size) {
+    string signature = histogramSignature(symFreq, size);
+
+    {
+        lock_guard<mutex> guard(lock);
+        auto found = index.find(signature);
+        if (found != index.end()) {
+            // Move it to the front.
+            entries.splice(entries.begin(), entries, found->second);
+            hitCount++;
+            return found->second->tree;
+        }
+    }
+
+    // Build outside the lock, so other threads can keep looking up.
+    shared_ptr<HCTree> tree(new HCTree());
+    tree->build(symFreq);
+    missCount++;
+
+    lock_guard<mutex> guard(lock);
+    auto found = index.find(signature);
+    if (found != index.end()) {
+        // Another thread built one meanwhile; keep the cached one.
+        return found->second->tree;
+    }
+    Entry entry = {signature, tree};
+    entries.push_front(entry);
+    index[signature] = entries.begin();
+    if (entries.size() > capacity) {
+        index.erase(entries.back().signature);
+        entries.pop_back();
+    }
+    return tree;
+}
+
+size_t TreeCache::size() {
+    lock_guard<mutex> guard(lock);
+    return entries.size();
+}
@@ -0,0 +1,93 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides a cache of built Huffman trees, shared by the threads
+ * of a long-running process. Blocks from the same kind of data have
+ * similar histograms, and a tree built for one of them codes the others
+ * almost as well, so instead of building a tree per block the encoder
+ * looks one up by the block's histogram signature: for every byte, zero
+ * if it does not occur, otherwise its -log2 probability in half-bit steps.
+ * Blocks with the same signature contain exactly the same bytes, so the
+ * cached tree has a code for every one of them. The least recently used
+ * tree is dropped when the cache is full.
+ */
+
+#ifndef TREECACHE_HPP
+#define TREECACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HCTree.hpp"
+using namespace std;
+
+// Default number of trees a cache holds.
+const size_t TREE_CACHE_SIZE = 256;
+
+/**
+ * A thread-safe LRU cache of trees keyed by histogram signature.
+ */
+class TreeCache {
+private:
+    /**
+     * A cached tree and its signature.
+     */
+    struct Entry {
+        string signature;
+        shared_ptr<HCTree> tree;
+    };
+
+    // Most recently used first, with an index by signature.
+    list<Entry> entries;
+    unordered_map<string, list<Entry>::iterator> index;
+    size_t capacity;
+    mutex lock;
+
+    atomic<uint64_t> hitCount;
+    atomic<uint64_t> missCount;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param capacity the most trees to keep (at least 1)
+     */
+    explicit TreeCache(size_t capacity = TREE_CACHE_SIZE);
+
+    /**
+     * Find the tree for a histogram, building and caching it if there is
+     * none yet. The tree stays valid for as long as the caller holds it,
+     * even if it is dropped from the cache meanwhile.
+     *
+     * @param symFreq how often each byte occurs (some byte > 0)
+     * @param size the sum of symFreq
+     * @return a tree with a code for every byte that occurs
+     */
+    shared_ptr<HCTree> treeFor(const vector<int>& symFreq, size_t size);
+
+    /**
+     * @return how many lookups found a tree
+     */
+    uint64_t hits() const { return hitCount.load(); }
+
+    /**
+     * @return how many lookups had to build one
+     */
+    uint64_t misses() const { return missCount.load(); }
+
+    /**
+     * @return how many trees are cached
+     */
+    size_t size();
+};
+
+#endif // TREECACHE_HPP
@@ -0,0 +1,196 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: io_uring(7), io_uring_setup(2) and io_uring_enter(2) man
+ *               pages.
+ *
+ * This file provides the implementation of the minimal io_uring wrapper.
+ */
+
+#include "Uring.hpp"
+#include "Helper.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * Constructor, which tries to set up an io_uring with the given depth
+ *
+ * @param entries how many requests can be in flight at once
+ */
+Uring::Uring(unsigned entries)
+    : ringFd(-1), sqTail(nullptr), sqMask(nullptr), sqArray(nullptr),
+      sqes(nullptr), cqHead(nullptr), cqTail(nullptr), cqMask(nullptr),
+      cqes(nullptr), sqPtr(MAP_FAILED), sqLen(0), cqPtr(MAP_FAILED),
+      cqLen(0), sqesLen(0), unsubmitted(0) {
+
+#ifdef __NR_io_uring_setup
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+
+    // No io_uring (old kernel, seccomp, ...): leave ringFd at -1.
+    if (fd < 0) {
+        return;
+    }
+
+    sqLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqLen = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // Newer kernels map both rings with a single mmap.
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        sqLen = cqLen = (sqLen > cqLen) ? sqLen : cqLen;
+    }
+
+    sqPtr = mmap(nullptr, sqLen, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqPtr == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+
+    if (single) {
+        cqPtr = sqPtr;
+    } else {
+        cqPtr = mmap(nullptr, cqLen, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED) {
+            munmap(sqPtr, sqLen);
+            sqPtr = MAP_FAILED;
+            close(fd);
+            return;
+        }
+    }
+
+    sqesLen = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED) {
+        if (cqPtr != sqPtr) {
+            munmap(cqPtr, cqLen);
+        }
+        munmap(sqPtr, sqLen);
+        sqPtr = cqPtr = MAP_FAILED;
+        close(fd);
+        return;
+    }
+
+    char* sq = (char*)sqPtr;
+    char* cq = (char*)cqPtr;
+    sqTail = (unsigned*)(sq + params.sq_off.tail);
+    sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + params.sq_off.array);
+    sqes = (io_uring_sqe*)sqesPtr;
+    cqHead = (unsigned*)(cq + params.cq_off.head);
+    cqTail = (unsigned*)(cq + params.cq_off.tail);
+    cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    ringFd = fd;
+#else
+    (void)entries;
+#endif
+}
+
+/**
+ * Destructor, which unmaps the rings and closes the io_uring
+ */
+Uring::~Uring() {
+    if (ringFd < 0) {
+        return;
+    }
+    munmap(sqes, sqesLen);
+    if (cqPtr != sqPtr) {
+        munmap(cqPtr, cqLen);
+    }
+    munmap(sqPtr, sqLen);
+    close(ringFd);
+}
+
+/**
+ * Queue one request in the submission ring. The caller never has more
+ * requests in flight than the ring has entries, so there is always room.
+ */
+void Uring::prepare(int opcode, int fd, void* buf, unsigned len,
+                    uint64_t offset, uint64_t userData) {
+    unsigned tail = *sqTail;
+    unsigned index = tail & *sqMask;
+
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+
+    sqArray[index] = index;
+
+    // Make the entry visible to the kernel before moving the tail.
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    unsubmitted++;
+}
+
+void Uring::read(int fd, void* buf, unsigned len, uint64_t offset,
+                 uint64_t userData) {
+    prepare(IORING_OP_READ, fd, buf, len, offset, userData);
+}
+
+void Uring::write(int fd, const void* buf, unsigned len, uint64_t offset,
+                  uint64_t userData) {
+    prepare(IORING_OP_WRITE, fd, (void*)buf, len, offset, userData);
+}
+
+/**
+ * Hand all queued requests to the kernel.
+ */
+void Uring::submit() {
+    while (unsubmitted > 0) {
+        int n = (int)syscall(__NR_io_uring_enter, ringFd, unsubmitted, 0, 0,
+                             nullptr, 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            error("io_uring_enter failed: " + string(strerror(errno)));
+        }
+        unsubmitted -= n;
+    }
+}
+
+/**
+ * Wait for one request to complete.
+ *
+ * @param userData set to the userData of the completed request
+ * @return the result of the request (bytes transferred or -errno)
+ */
+int Uring::wait(uint64_t& userData) {
+    submit();
+
+    unsigned head = *cqHead;
+
+    // Block in the kernel until the completion ring is non-empty.
+    while (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        int n = (int)syscall(__NR_io_uring_enter, ringFd, 0, 1,
+                             IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (n < 0 && errno != EINTR) {
+            error("io_uring_enter failed: " + string(strerror(errno)));
+        }
+    }
+
+    io_uring_cqe* cqe = &cqes[head & *cqMask];
+    userData = cqe->user_data;
+    int res = cqe->res;
+
+    // Hand the completion slot back to the kernel.
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return res;
+}
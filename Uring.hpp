@@ -0,0 +1,107 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: io_uring(7), io_uring_setup(2) and io_uring_enter(2) man
+ *               pages.
+ *
+ * This file provides a minimal wrapper around the Linux io_uring system
+ * calls (no liburing needed), used by BlockPipeline to keep several block
+ * reads/writes in flight. If the kernel does not support io_uring, ok()
+ * returns false and the caller falls back to plain pread/pwrite.
+ */
+
+#ifndef URING_HPP
+#define URING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * A single io_uring instance with one submission and one completion queue.
+ * Not thread safe: each stage that uses it owns its own instance.
+ */
+class Uring {
+private:
+    int ringFd;             // io_uring file descriptor, -1 if unavailable
+
+    // Submission queue ring (shared with the kernel)
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    io_uring_sqe* sqes;
+
+    // Completion queue ring (shared with the kernel)
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    io_uring_cqe* cqes;
+
+    // Mappings, so we can unmap them again
+    void* sqPtr;
+    size_t sqLen;
+    void* cqPtr;
+    size_t cqLen;
+    size_t sqesLen;
+
+    // Entries prepared but not yet handed to the kernel
+    unsigned unsubmitted;
+
+    /**
+     * Queue one request in the submission ring.
+     */
+    void prepare(int opcode, int fd, void* buf, unsigned len,
+                 uint64_t offset, uint64_t userData);
+
+public:
+    /**
+     * Constructor, which tries to set up an io_uring with the given depth
+     *
+     * @param entries how many requests can be in flight at once
+     */
+    explicit Uring(unsigned entries);
+
+    /**
+     * Destructor, which unmaps the rings and closes the io_uring
+     */
+    ~Uring();
+
+    /**
+     * @return true if the kernel gave us a working io_uring
+     */
+    bool ok() const { return ringFd >= 0; }
+
+    /**
+     * Queue a read of len bytes at offset of fd into buf.
+     *
+     * @param userData value handed back by wait() on completion
+     */
+    void read(int fd, void* buf, unsigned len, uint64_t offset,
+              uint64_t userData);
+
+    /**
+     * Queue a write of len bytes from buf to offset of fd.
+     *
+     * @param userData value handed back by wait() on completion
+     */
+    void write(int fd, const void* buf, unsigned len, uint64_t offset,
+               uint64_t userData);
+
+    /**
+     * Hand all queued requests to the kernel.
+     */
+    void submit();
+
+    /**
+     * Wait for one request to complete.
+     *
+     * @param userData set to the userData of the completed request
+     * @return the result of the request (bytes transferred or -errno)
+     */
+    int wait(uint64_t& userData);
+};
+
+#endif // URING_HPP
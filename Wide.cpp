@@ -0,0 +1,321 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides the implementation of the wide-alphabet coder.
+ */
+
+#include "Wide.hpp"
+#include "BitIO.hpp"
+#include "Helper.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+
+// Number of 16-bit symbols.
+static const int WIDE_SYMBOLS = 1 << 16;
+
+// Bits used to store the number of distinct symbols (up to WIDE_SYMBOLS).
+static const int COUNT_BITS = 17;
+
+// Bits used to store a code length (up to WIDE_MAX_BITS).
+static const int LENGTH_BITS = 5;
+
+/**
+ * One entry of the decoding table: the symbol whose code is a prefix of
+ * the looked up bits, and the length of that code (0 if the code is
+ * longer than the table).
+ */
+struct WideDecodeEntry {
+    uint16_t symbol;
+    unsigned char length;
+};
+
+/**
+ * @return the position of the highest set bit of x (x > 0)
+ */
+static inline int highBit(uint32_t x) {
+    return 31 - __builtin_clz(x);
+}
+
+/**
+ * Write a positive number as an Elias gamma code: as many zero bits as
+ * the number has bits after its highest one, then the number.
+ *
+ * @param value the number (> 0)
+ * @param out bit writer
+ */
+static void writeGamma(uint32_t value, BitWriter& out) {
+    int bits = highBit(value);
+    out.write_bits(0, bits);
+    out.write_bits(value, bits + 1);
+}
+
+/**
+ * Read an Elias gamma code.
+ *
+ * @param in bit reader
+ * @return the number
+ */
+static uint32_t readGamma(BitReader& in) {
+    int bits = 0;
+    while (in.read_bit() == 0) {
+        if (++bits > COUNT_BITS || !in.good()) {
+            error("Corrupt block payload");
+        }
+    }
+    return (1u << bits) | (uint32_t)in.read_bits(bits);
+}
+
+/**
+ * Compute Huffman code lengths. Codes longer than WIDE_MAX_BITS are
+ * avoided by flattening the weights and trying again.
+ *
+ * @param weights how often each symbol occurs (all > 0)
+ * @param lengths set to the code length of each symbol (0 if only one)
+ */
+static void codeLengths(vector<uint64_t> weights,
+                        vector<unsigned char>& lengths) {
+    size_t m = weights.size();
+    lengths.assign(m, 0);
+    if (m < 2) {
+        return;
+    }
+
+    typedef pair<uint64_t, int> Entry;
+    vector<int> parent(2 * m - 1);
+    vector<int> depth(2 * m - 1);
+    while (true) {
+        // Huffman's algorithm on node indices: leaves first, then every
+        // merged node, so a parent always has a higher index than its
+        // children.
+        priority_queue<Entry, vector<Entry>, greater<Entry> > pq;
+        for (size_t i = 0; i < m; i++) {
+            pq.push(Entry(weights[i], i));
+        }
+        int next = m;
+        while (pq.size() > 1) {
+            Entry a = pq.top();
+            pq.pop();
+            Entry b = pq.top();
+            pq.pop();
+            parent[a.second] = parent[b.second] = next;
+            pq.push(Entry(a.first + b.first, next++));
+        }
+
+        // Depths follow from the root (the last node) down.
+        int maxLength = 0;
+        depth[2 * m - 2] = 0;
+        for (int i = 2 * m - 3; i >= 0; i--) {
+            depth[i] = depth[parent[i]] + 1;
+            maxLength = max(maxLength, depth[i]);
+        }
+        if (maxLength <= WIDE_MAX_BITS) {
+            break;
+        }
+        for (size_t i = 0; i < m; i++) {
+            weights[i] = (weights[i] + 1) / 2;
+        }
+    }
+
+    for (size_t i = 0; i < m; i++) {
+        lengths[i] = depth[i];
+    }
+}
+
+/**
+ * Assign canonical codes: ordered by length, then by symbol, every code
+ * is the one after the previous code, shifted to its length.
+ *
+ * @param lengths the code length of each symbol (symbols in increasing
+ *                order, all lengths > 0)
+ * @param order set to the symbol indices in code order
+ * @param codes set to the code of each symbol
+ * @return false if the lengths do not make a prefix code
+ */
+static bool canonicalCodes(const vector<unsigned char>& lengths,
+                           vector<int>& order, vector<uint32_t>& codes) {
+    size_t m = lengths.size();
+    order.resize(m);
+    for (size_t i = 0; i < m; i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return lengths[a] < lengths[b];
+    });
+
+    codes.resize(m);
+    uint32_t code = 0;
+    int prevLength = 0;
+    for (size_t i = 0; i < m; i++) {
+        int length = lengths[order[i]];
+        code <<= length - prevLength;
+        prevLength = length;
+        if (code >> length != 0) {
+            return false;
+        }
+        codes[order[i]] = code++;
+    }
+    return true;
+}
+
+void encodeWide(const unsigned char* data, size_t size,
+                vector<unsigned char>& out) {
+    size_t count = size / 2;
+
+    // Count the symbols; the tables are kept per thread and only the
+    // entries that were used are cleared again.
+    static thread_local vector<uint32_t> freq(WIDE_SYMBOLS);
+    static thread_local vector<uint32_t> codeOf(WIDE_SYMBOLS);
+    static thread_local vector<unsigned char> lengthOf(WIDE_SYMBOLS);
+    vector<uint16_t> symbols;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t sym = data[2 * i] | data[2 * i + 1] << 8;
+        if (freq[sym]++ == 0) {
+            symbols.push_back(sym);
+        }
+    }
+    sort(symbols.begin(), symbols.end());
+
+    vector<uint64_t> weights(symbols.size());
+    for (size_t i = 0; i < symbols.size(); i++) {
+        weights[i] = freq[symbols[i]];
+        freq[symbols[i]] = 0;
+    }
+    vector<unsigned char> lengths;
+    codeLengths(weights, lengths);
+
+    vector<int> order;
+    vector<uint32_t> codes;
+    if (symbols.size() > 1) {
+        canonicalCodes(lengths, order, codes);
+    } else {
+        codes.assign(symbols.size(), 0);
+    }
+
+    // The sparse alphabet: gaps between the symbols, and their lengths.
+    BitWriter bits(out);
+    bits.write_bits(symbols.size(), COUNT_BITS);
+    int prev = -1;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        writeGamma(symbols[i] - prev, bits);
+        bits.write_bits(lengths[i], LENGTH_BITS);
+        prev = symbols[i];
+        codeOf[symbols[i]] = codes[i];
+        lengthOf[symbols[i]] = lengths[i];
+    }
+    if (size % 2 != 0) {
+        bits.write_bits(data[size - 1], 8);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint16_t sym = data[2 * i] | data[2 * i + 1] << 8;
+        bits.write_bits(codeOf[sym], lengthOf[sym]);
+    }
+    bits.flush();
+}
+
+void decodeWide(const unsigned char* payload, size_t payloadSize,
+                unsigned char* out, size_t size) {
+    BitReader bits(payload, payloadSize);
+    size_t count = size / 2;
+
+    // Read the sparse alphabet back.
+    size_t m = bits.read_bits(COUNT_BITS);
+    if (m > WIDE_SYMBOLS || (m == 0 && count != 0)) {
+        error("Corrupt block payload");
+    }
+    vector<uint16_t> symbols(m);
+    vector<unsigned char> lengths(m);
+    int prev = -1;
+    for (size_t i = 0; i < m; i++) {
+        int sym = prev + readGamma(bits);
+        int length = bits.read_bits(LENGTH_BITS);
+        if (sym >= WIDE_SYMBOLS || length > WIDE_MAX_BITS ||
+            (length == 0) != (m == 1) || !bits.good()) {
+            error("Corrupt block payload");
+        }
+        symbols[i] = sym;
+        lengths[i] = length;
+        prev = sym;
+    }
+    if (size % 2 != 0) {
+        out[size - 1] = bits.read_bits(8);
+    }
+
+    // A single symbol has no code at all.
+    if (m == 1) {
+        for (size_t i = 0; i < count; i++) {
+            out[2 * i] = symbols[0];
+            out[2 * i + 1] = symbols[0] >> 8;
+        }
+        if (!bits.good()) {
+            error("Corrupt block payload");
+        }
+        return;
+    }
+
+    vector<int> order;
+    vector<uint32_t> codes;
+    if (!canonicalCodes(lengths, order, codes)) {
+        error("Corrupt block payload");
+    }
+
+    // Short codes go in the table; longer ones are found by length, as
+    // the codes of one length are consecutive in canonical order.
+    vector<WideDecodeEntry> table(1 << WIDE_TABLE_BITS);
+    uint32_t first[WIDE_MAX_BITS + 1] = {0};
+    uint32_t number[WIDE_MAX_BITS + 1] = {0};
+    int start[WIDE_MAX_BITS + 1] = {0};
+    int maxLength = 0;
+    for (size_t i = 0; i < m; i++) {
+        int s = order[i];
+        int length = lengths[s];
+        if (number[length]++ == 0) {
+            first[length] = codes[s];
+            start[length] = i;
+        }
+        maxLength = length;
+
+        if (length <= WIDE_TABLE_BITS) {
+            int shift = WIDE_TABLE_BITS - length;
+            WideDecodeEntry entry = {symbols[s], (unsigned char)length};
+            fill(table.begin() + (codes[s] << shift),
+                 table.begin() + ((codes[s] + 1) << shift), entry);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const WideDecodeEntry& entry = table[bits.peek(WIDE_TABLE_BITS)];
+        uint16_t sym = entry.symbol;
+        if (entry.length != 0) {
+            bits.skip(entry.length);
+        } else {
+            int length = WIDE_TABLE_BITS + 1;
+            for (; length <= maxLength; length++) {
+                uint32_t code = bits.peek(length);
+                if (code - first[length] < number[length]) {
+                    sym = symbols[order[start[length] +
+                                        code - first[length]]];
+                    break;
+                }
+            }
+            if (length > maxLength) {
+                error("Corrupt block payload");
+            }
+            bits.skip(length);
+        }
+
+        // Two output bytes per code.
+        out[2 * i] = sym;
+        out[2 * i + 1] = sym >> 8;
+    }
+
+    if (!bits.good()) {
+        error("Corrupt block payload");
+    }
+}
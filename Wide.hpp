@@ -0,0 +1,59 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: Huffman Lecture Slides.
+ *
+ * This file provides wide-alphabet coding for the block format. The block
+ * is read as 16-bit little-endian symbols (e.g. sensor samples or token
+ * ids) instead of bytes, so a symbol that spans two bytes gets one code
+ * for both. Such an alphabet is large and usually sparse, so instead of a
+ * serialized tree the payload lists only the symbols that occur, with
+ * their code lengths, and both sides derive the same canonical codes from
+ * them. The payload of a METHOD_WIDE block is:
+ *
+ *   number of distinct symbols (17 bits)
+ *   for each symbol, in increasing order: the gap from the previous one
+ *   (Elias gamma) and its code length (5 bits)
+ *   the last byte, if the block has an odd size (8 bits)
+ *   bitstream
+ *
+ * The decoder resolves codes of up to WIDE_TABLE_BITS bits with one table
+ * lookup that yields two output bytes.
+ */
+
+#ifndef WIDE_HPP
+#define WIDE_HPP
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// Codes are limited to this many bits.
+const int WIDE_MAX_BITS = 24;
+
+// Bits looked up at once by the decoder.
+const int WIDE_TABLE_BITS = 12;
+
+/**
+ * Code a block as 16-bit symbols and append the payload to out.
+ *
+ * @param data the raw bytes
+ * @param size how many bytes (> 0)
+ * @param out the output bytes
+ */
+void encodeWide(const unsigned char* data, size_t size,
+                vector<unsigned char>& out);
+
+/**
+ * Decode a wide-alphabet payload.
+ *
+ * @param payload the payload bytes
+ * @param payloadSize how many payload bytes
+ * @param out where to store the decoded bytes
+ * @param size how many bytes to decode
+ */
+void decodeWide(const unsigned char* payload, size_t payloadSize,
+                unsigned char* out, size_t size);
+
+#endif // WIDE_HPP
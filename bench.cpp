@@ -0,0 +1,261 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides an in-memory benchmark of the block format. Every
+ * input file is loaded into memory and repeatedly coded and decoded
+ * block by block, so the numbers measure the coder itself and not the
+ * disk. Each file is run without and with per-block CRC32C checksums,
+ * and the checksum overhead is printed as a percentage. A second table
+ * compares the Huffman and tANS coders head to head on the same blocks.
+ * The depth column is the longest code of a tree built over the whole
+ * file, so slow decoding can be told apart from deep trees (see
+ * gencorpus.cpp for inputs that make them).
+ *
+ * Usage: bench file...
+ */
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "BlockFormat.hpp"
+#include "Checksum.hpp"
+#include "HCTree.hpp"
+#include "Helper.hpp"
+
+// Block size used for the benchmark (same as compress).
+static const size_t BENCH_BLOCK_SIZE = 1 << 20;
+
+// Each measurement repeats until it has run for at least this long.
+static const double MIN_SECONDS = 0.2;
+
+// How many times each measurement is taken (the best one counts).
+static const int BENCH_ROUNDS = 3;
+
+/**
+ * Code all of data in the block format.
+ *
+ * @param data the input
+ * @param header the file header to use
+ * @param out set to the coded bytes
+ * @param options how to code each block
+ */
+static void encodeAll(const vector<unsigned char>& data,
+                      const FileHeader& header, vector<unsigned char>& out,
+                      const EncodeOptions& options = EncodeOptions()) {
+    out.clear();
+    writeFileHeader(header, out);
+    for (size_t pos = 0; pos < data.size(); pos += header.blockSize) {
+        size_t size = min((size_t)header.blockSize, data.size() - pos);
+        encodeBlock(data.data() + pos, size, header, out, options);
+    }
+    writeEndBlock(header, out);
+}
+
+/**
+ * Decode a whole block format buffer.
+ *
+ * @param coded the coded bytes
+ * @param out where to decode to (big enough for the whole input)
+ */
+static void decodeAll(const vector<unsigned char>& coded,
+                      vector<unsigned char>& out) {
+    BitReader bits(coded.data(), coded.size());
+    bits.read<uint32_t>();
+    FileHeader header = readFileHeader(bits);
+
+    BlockHeader block;
+    vector<unsigned char> payload;
+    size_t written = 0;
+    while (readBlockHeader(bits, header, block)) {
+        payload.resize(block.payloadSize);
+        bits.readBytes(payload.data(), block.payloadSize);
+        decodeBlock(header, block, payload.data(), out.data() + written);
+        written += block.rawSize;
+    }
+}
+
+/**
+ * @return CPU time used by this thread, in seconds
+ */
+static double cpuSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Run work repeatedly for at least MIN_SECONDS of CPU time. CPU time
+ * rather than wall time keeps other processes out of the numbers.
+ *
+ * @param bytes how many input bytes one run processes
+ * @param work the work to time
+ * @return throughput in MB/s
+ */
+template<typename Work>
+static double measure(size_t bytes, Work work) {
+    double start = cpuSeconds();
+    double seconds = 0;
+    size_t runs = 0;
+    do {
+        work();
+        runs++;
+        seconds = cpuSeconds() - start;
+    } while (seconds < MIN_SECONDS);
+    return (double)bytes * runs / seconds / 1e6;
+}
+
+/**
+ * Load a whole file.
+ *
+ * @param path the file
+ * @return its contents
+ */
+static vector<unsigned char> loadFile(const string& path) {
+    ifstream file(path, ios::binary);
+    return vector<unsigned char>((istreambuf_iterator<char>(file)),
+                                 istreambuf_iterator<char>());
+}
+
+/**
+ * @param data the input
+ * @return the length of the longest code of a tree built over all of it
+ */
+static int maxCodeLength(const vector<unsigned char>& data) {
+    vector<int> symFreq(256, 0);
+    for (unsigned char c : data) {
+        symFreq[c]++;
+    }
+    HCTree tree;
+    tree.build(symFreq);
+
+    int depth = 0;
+    for (int s = 0; s < 256; s++) {
+        depth = max(depth, tree.codeLength(s));
+    }
+    return depth;
+}
+
+/**
+ * Benchmark one file without and with checksums.
+ *
+ * @param path the file
+ */
+static void benchFile(const string& path) {
+    vector<unsigned char> data = loadFile(path);
+    if (data.empty()) {
+        return;
+    }
+
+    FileHeader header = {BLOCK_VERSION, 0, BENCH_BLOCK_SIZE, data.size()};
+    vector<unsigned char> coded;
+    vector<unsigned char> decoded(data.size());
+
+    // Alternate between the two modes a few times and keep the best
+    // rate of each, so background noise does not end up in the overhead.
+    double encodeRate[2] = {0, 0};
+    double decodeRate[2] = {0, 0};
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int withChecksum = 0; withChecksum < 2; withChecksum++) {
+            header.flags = withChecksum ? FLAG_CHECKSUM : 0;
+
+            encodeRate[withChecksum] = max(encodeRate[withChecksum],
+                measure(data.size(), [&]() {
+                    encodeAll(data, header, coded);
+                }));
+            decodeRate[withChecksum] = max(decodeRate[withChecksum],
+                measure(data.size(), [&]() {
+                    decodeAll(coded, decoded);
+                }));
+
+            if (decoded != data) {
+                error("Benchmark round trip failed for " + path);
+            }
+        }
+    }
+
+    string name = path.substr(path.find_last_of('/') + 1);
+    printf("%-20s %12zu %6d %10.1f %10.1f %9.2f%% %9.2f%%\n", name.c_str(),
+           data.size(), maxCodeLength(data), encodeRate[0], decodeRate[0],
+           100.0 * (encodeRate[0] / encodeRate[1] - 1),
+           100.0 * (decodeRate[0] / decodeRate[1] - 1));
+}
+
+/**
+ * Benchmark one file with the Huffman and the tANS coder.
+ *
+ * @param path the file
+ */
+static void benchCoders(const string& path) {
+    vector<unsigned char> data = loadFile(path);
+    if (data.empty()) {
+        return;
+    }
+
+    FileHeader header = {BLOCK_VERSION, 0, BENCH_BLOCK_SIZE, data.size()};
+    vector<unsigned char> coded;
+    vector<unsigned char> decoded(data.size());
+
+    // Index 0 is Huffman, 1 is tANS; rounds alternate as above.
+    EncodeOptions options[2];
+    options[1].coder = CODER_ANS;
+    double encodeRate[2] = {0, 0};
+    double decodeRate[2] = {0, 0};
+    size_t codedSize[2] = {0, 0};
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int coder = 0; coder < 2; coder++) {
+            encodeRate[coder] = max(encodeRate[coder],
+                measure(data.size(), [&]() {
+                    encodeAll(data, header, coded, options[coder]);
+                }));
+            decodeRate[coder] = max(decodeRate[coder],
+                measure(data.size(), [&]() {
+                    decodeAll(coded, decoded);
+                }));
+            codedSize[coder] = coded.size();
+
+            if (decoded != data) {
+                error("Benchmark round trip failed for " + path);
+            }
+        }
+    }
+
+    string name = path.substr(path.find_last_of('/') + 1);
+    printf("%-20s %12zu %10.1f %10.1f %12zu %10.1f %10.1f\n", name.c_str(),
+           codedSize[0], encodeRate[0], decodeRate[0],
+           codedSize[1], encodeRate[1], decodeRate[1]);
+}
+
+/**
+ * The Main function of the benchmark.
+ *
+ * @param argc the number of program arguments
+ * @param argv the files to benchmark
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        error("Usage: bench file...\n");
+        return 1;
+    }
+
+    printf("CRC32C: %s\n", crc32cHardware() ? "SSE4.2" : "software table");
+    printf("%-20s %12s %6s %10s %10s %10s %10s\n", "file", "bytes", "depth",
+           "enc MB/s", "dec MB/s", "crc enc", "crc dec");
+
+    for (int i = 1; i < argc; i++) {
+        benchFile(argv[i]);
+    }
+
+    printf("\n%-20s %12s %10s %10s %12s %10s %10s\n", "file", "huf bytes",
+           "huf enc", "huf dec", "ans bytes", "ans enc", "ans dec");
+    for (int i = 1; i < argc; i++) {
+        benchCoders(argv[i]);
+    }
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+# Name: Hariz Megat Zariman
+# Email: mqmegatz@ucsd.edu
+#
+# Sources Used: None.
+#
+# This file provides the streaming check of decompress -m: a long stream of
+# gencorpus output is piped through compress -b and decompress -m, the
+# result is compared with the input by checksum, and the peak resident
+# memory of decompress (from /usr/bin/time -f %M where it is installed,
+# otherwise from its own report) must stay under the limit.
+#
+# Usage: check-stream.sh [limit] [parts]
+#   limit  the memory limit passed to decompress -m (default 16M)
+#   parts  number of 16M pieces of gencorpus output to stream (default 8)
+
+LIMIT=${1:-16M}
+PARTS=${2:-8}
+LOG=${TMPDIR:-/tmp}/check-stream.$$
+trap 'rm -f "$LOG" "$LOG.rss"' EXIT
+
+# The input, one seed per piece so the stream does not repeat.
+generate() {
+    seed=1
+    while [ "$seed" -le "$PARTS" ]; do
+        ./gencorpus -s "$seed" -n 16M bursty /dev/stdout || exit 1
+        seed=$((seed + 1))
+    done
+}
+
+if [ -x /usr/bin/time ]; then
+    TIME="/usr/bin/time -f %M -o $LOG.rss"
+else
+    TIME=
+fi
+
+expected=$(generate | cksum)
+actual=$(generate | ./compress -b /dev/stdin /dev/stdout |
+         $TIME ./decompress -m "$LIMIT" - - 2>"$LOG" | cksum)
+
+if [ "$actual" != "$expected" ]; then
+    cat "$LOG" >&2
+    echo "check-stream: output differs from the input" >&2
+    exit 1
+fi
+
+# decompress prints "peak memory: <peak> MiB (limit <limit> MiB)".
+limitKiB=$(sed -n 's/.*(limit \([0-9.]*\) MiB).*/\1/p' "$LOG" |
+           awk '{ printf "%d", $1 * 1024 }')
+if [ -s "$LOG.rss" ]; then
+    peakKiB=$(tail -n 1 "$LOG.rss")
+else
+    peakKiB=$(sed -n 's/^peak memory: \([0-9.]*\) MiB.*/\1/p' "$LOG" |
+              awk '{ printf "%d", $1 * 1024 }')
+fi
+if [ -z "$peakKiB" ] || [ -z "$limitKiB" ]; then
+    cat "$LOG" >&2
+    echo "check-stream: no peak memory reported" >&2
+    exit 1
+fi
+
+echo "check-stream: $((PARTS * 16)) MiB in a peak of $peakKiB KiB" \
+     "(limit $limitKiB KiB)"
+if [ "$peakKiB" -gt "$limitKiB" ]; then
+    echo "check-stream: peak memory over the limit" >&2
+    exit 1
+fi
@@ -0,0 +1,144 @@
+#!/bin/sh
+#
+# Name: Hariz Megat Zariman
+# Email: mqmegatz@ucsd.edu
+#
+# Sources Used: None.
+#
+# This file provides the round-trip check behind make check. Every input
+# is compressed in each mode of compress, and every output is decompressed
+# from a file and from a pipe and must give back the input. Block format
+# outputs are also decoded with -m, single-stream outputs with -j 1 and
+# -j 4 (the parallel decoder, for inputs large enough), and the default
+# single-stream output is transcoded to the indexed block format and
+# decoded from that as well. Finally all the inputs go through one archive
+# (compress -a and decompress -x).
+#
+# Usage: check.sh input...
+
+WORK=${TMPDIR:-/tmp}/check.$$
+mkdir -p "$WORK" || exit 1
+trap 'rm -rf "$WORK"' EXIT
+
+passed=0
+failed=0
+
+# Count a step that passed.
+pass() {
+    passed=$((passed + 1))
+}
+
+# Count a step that failed.
+#   $1 what was checked
+fail() {
+    failed=$((failed + 1))
+    echo "FAIL: $1" >&2
+}
+
+# Compare the input with a decoded output.
+#   $1 the input, $2 the decoded output, $3 what was checked
+verify() {
+    if cmp -s "$1" "$2"; then
+        pass
+    else
+        fail "$3"
+    fi
+    rm -f "$2"
+}
+
+# Decode a compressed file in every way that applies to it.
+#   $1 the input, $2 the compressed file, $3 its format (single, block or
+#   adaptive), $4 what it is
+decodeAll() {
+    ./decompress "$2" "$WORK/out" 2>/dev/null
+    verify "$1" "$WORK/out" "decompress file $4"
+    ./decompress - - <"$2" >"$WORK/out" 2>/dev/null
+    verify "$1" "$WORK/out" "decompress pipe $4"
+
+    case "$3" in
+    single)
+        ./decompress -j 1 "$2" "$WORK/out" 2>/dev/null
+        verify "$1" "$WORK/out" "decompress -j 1 $4"
+        ./decompress -j 4 "$2" "$WORK/out" 2>/dev/null
+        verify "$1" "$WORK/out" "decompress -j 4 $4"
+        ;;
+    block)
+        ./decompress -j 4 "$2" "$WORK/out" 2>/dev/null
+        verify "$1" "$WORK/out" "decompress -j 4 $4"
+        ./decompress -m 16M - - <"$2" >"$WORK/out" 2>/dev/null
+        verify "$1" "$WORK/out" "decompress -m 16M $4"
+        ;;
+    esac
+}
+
+for input in "$@"; do
+    echo "$input"
+
+    # Each line is a format and the options of compress that write it.
+    while read -r format options; do
+        name="$input (compress $options)"
+
+        # The word splitting of $options is intended.
+        if ! ./compress $options "$input" "$WORK/packed" >/dev/null 2>&1
+        then
+            fail "compress $name"
+            continue
+        fi
+        pass
+        decodeAll "$input" "$WORK/packed" "$format" "$name"
+
+        # The default output is also migrated to the indexed block format.
+        if [ -z "$options" ]; then
+            if ./transcode -c "$WORK/packed" "$WORK/indexed" 2>/dev/null
+            then
+                pass
+                decodeAll "$input" "$WORK/indexed" block \
+                    "$input (transcode)"
+            else
+                fail "transcode $name"
+            fi
+        fi
+    done <<EOF
+single
+single -s
+block -b
+block -c
+block -o
+block -w
+block -e ans
+block -e auto
+block -t delta1
+block -t delta4
+block -t mtf
+block -t planes2
+block -t auto
+block -c -o -w -e auto -t auto
+adaptive -A
+EOF
+done
+
+# All the inputs in one archive, extracted on a thread pool.
+if [ $# -gt 0 ]; then
+    echo "archive"
+    : >"$WORK/list"
+    index=0
+    for input in "$@"; do
+        printf '%s\t%s\n' "$input" "$index" >>"$WORK/list"
+        index=$((index + 1))
+    done
+    if ./compress -a -l "$WORK/list" "$WORK/archive" >/dev/null 2>&1 &&
+       ./decompress -j 4 -x "$WORK/archive" "$WORK/extracted" 2>/dev/null
+    then
+        pass
+        index=0
+        for input in "$@"; do
+            verify "$input" "$WORK/extracted/$index" "archive entry $input"
+            index=$((index + 1))
+        done
+    else
+        fail "archive of every input"
+    fi
+fi
+
+echo "$passed passed, $failed failed"
+[ "$failed" -eq 0 ]
@@ -7,101 +7,614 @@
  * This file provides the main workflow to compress a file using
  * Huffman Encoding and writes the result to an output file. It handles
  * the input arguments, constructing a Huffamn Tree object and manipulation
- * of the Tree functions to accomplish this.
+ * of the Tree functions to accomplish this. Both passes over the input run
+ * through a BlockPipeline, so reading, coding and writing overlap.
+ *
+ * Usage: compress [-b] [-c] [-o] [-w] [-e coder] [-t transform] [-A] [-s]
+ *                 infile outfile
+ *        compress [-b] [-c] [-o] [-w] [-e coder] [-t transform]
+ *                 [-j threads] [-a] -l list out
+ *   -b  write the block format (see BlockFormat.hpp) instead of a single
+ *       stream
+ *   -c  protect every block with a CRC32C checksum (implies -b)
+ *   -o  code blocks with order-1 context trees where that is smaller
+ *       (implies -b)
+ *   -w  also code blocks as 16-bit little-endian symbols (e.g. samples
+ *       or token ids), where that is smaller (implies -b)
+ *   -e  entropy coder: huffman (default), ans, or auto to keep whichever
+ *       is smaller for each block (ans and auto imply -b)
+ *   -t  transform every block before coding it (see Transform.hpp):
+ *       delta1, delta2, delta4, delta8, mtf, planes2, planes4, planes8,
+ *       or auto to pick one per block by trial entropy (implies -b)
+ *   -l  batch mode: compress every file named in list, one per line as
+ *       "input" or "input<TAB>name", into the directory out (as out/name)
+ *   -a  in batch mode, write one archive (see Archive.hpp) to out instead
+ *   -j  number of batch mode threads (default: one per CPU)
+ *   -A  write the headerless adaptive format (see AdaptiveHCTree.hpp):
+ *       one pass, and every chunk of input is coded and written as soon
+ *       as it is read, for streams such as pipes or sockets
+ *   -s  single-stream format: build the tree from a random sample of a
+ *       large input instead of counting every byte first, and report how
+ *       much larger the output is than with the exact counts
+ *
+ * The single-stream format stores the number of symbols as an int, so
+ * larger inputs (over 2 GiB) need the block format (-b).
+ *
+ * In batch mode the files are compressed in memory on a thread pool, and
+ * every worker reuses its buffers and tree from one file to the next.
  */
 
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <vector>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AdaptiveHCTree.hpp"
+#include "Archive.hpp"
+#include "BlockFormat.hpp"
+#include "Codec.hpp"
 #include "HCTree.hpp"
 #include "Helper.hpp"
+#include "Pipeline.hpp"
+#include "ThreadPool.hpp"
 
 /**
- * The Main function of the compress program, handling input
- * argument, reading an input file and compressing it to an output file.
- * 
- * @param argc the number of program arguments
- * @param argv the arguments
- * @return 0 if program successful, otherwise stderr.
+ * One file of a batch.
  */
-int main( int argc, char** argv) {
+struct BatchItem {
+    string input; // the file to compress
+    string name;  // where it goes, relative to the output
+};
+
+/**
+ * Hand the encoded bytes collected so far to the writer stage.
+ *
+ * @param pipe the pipeline
+ * @param encoded the encoded bytes (emptied)
+ */
+static void emitEncoded(BlockPipeline& pipe, vector<unsigned char>& encoded) {
+    Block* block = pipe.acquireOutput();
+
+    // Swap buffers instead of copying; the BitWriter keeps appending to
+    // the (now empty) encoded vector.
+    swap(block->data, encoded);
+    block->size = block->data.size();
+    encoded.clear();
+    pipe.emitOutput(block);
+}
+
+// Smallest input worth sampling; below this every byte is counted.
+static const size_t SAMPLE_MIN_SIZE = 16 << 20;
+
+// One window of SAMPLE_WINDOW bytes is read from every SAMPLE_STRIDE
+// bytes of input (about 0.4% of it).
+static const size_t SAMPLE_STRIDE = 1 << 20;
+static const size_t SAMPLE_WINDOW = 4096;
+
+/**
+ * Estimate the byte frequencies of a large file from a strided random
+ * sample: one window at a random place in every stride. The counts are
+ * scaled up to the size of the file, and every byte value gets a count of
+ * at least one, so any byte the sample missed still has a code. The
+ * counts add up to exactly the size, which the header stores as the
+ * number of symbols to decode.
+ *
+ * @param inputFd the input file (its offset is left alone)
+ * @param symFreq set to the estimated frequencies
+ * @return the number of bytes sampled, or 0 if the input is not a
+ *         regular file of at least SAMPLE_MIN_SIZE bytes
+ */
+static size_t sampleFrequencies(int inputFd, vector<int>& symFreq) {
+    struct stat inputStat;
+    if (fstat(inputFd, &inputStat) != 0 || !S_ISREG(inputStat.st_mode) ||
+        (size_t)inputStat.st_size < SAMPLE_MIN_SIZE) {
+        return 0;
+    }
+    size_t size = inputStat.st_size;
+
+    // A fixed seed keeps the output the same from run to run.
+    mt19937_64 random(size);
+    vector<unsigned char> window(SAMPLE_WINDOW);
+    vector<uint64_t> counts(symFreq.size());
+    size_t sampled = 0;
+
+    for (size_t start = 0; start < size; start += SAMPLE_STRIDE) {
+        size_t stride = min(SAMPLE_STRIDE, size - start);
+        size_t length = min(SAMPLE_WINDOW, stride);
+        size_t offset = start + random() % (stride - length + 1);
+
+        ssize_t n = pread(inputFd, window.data(), length, offset);
+        if (n < 0) {
+            error("Cannot read input file\n");
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            counts[window[i]]++;
+        }
+        sampled += n;
+    }
+    if (sampled == 0) {
+        return 0;
+    }
+
+    // Scale up, with a floor of one, then make the counts add up to the
+    // size by adjusting the most frequent byte. The counts stay 64-bit
+    // until they are known to fit.
+    double scale = (double)size / sampled;
+    vector<int64_t> scaled(symFreq.size());
+    int64_t total = 0;
+    size_t largest = 0;
+    for (size_t b = 0; b < symFreq.size(); b++) {
+        scaled[b] = max<int64_t>(1, llround(counts[b] * scale));
+        total += scaled[b];
+        if (scaled[b] > scaled[largest]) {
+            largest = b;
+        }
+    }
+    scaled[largest] += (int64_t)size - total;
+    for (size_t b = 0; b < symFreq.size(); b++) {
+        if (scaled[b] < 1 || scaled[b] > INT_MAX) {
+            error("Input too large for the single-stream format (use -b)");
+        }
+        symFreq[b] = scaled[b];
+    }
+    return sampled;
+}
+
+/**
+ * Compress to the single-stream format: one tree for the whole input,
+ * built from a first pass over it (or from a sample of it), followed by
+ * one bitstream.
+ *
+ * @param inputFd the input file
+ * @param outputFd the output file
+ * @param sample true to build the tree from a sample of a large input
+ */
+static void compressStream(int inputFd, int outputFd, bool sample) {
 
     // Constants for styling purposes.
-    const int expectedArgs = 3;
-    const int secondArg = 2;
     const int maxFreq = 256;
 
-    // If we don't read the correct number of arguments, display an error
-    // and return to stderr.
-    if (argc != expectedArgs) {
-        error("Incorrect parameters\n");
-        return 1;
+    // The header stores the number of symbols as an int.
+    struct stat inputStat;
+    if (fstat(inputFd, &inputStat) == 0 && inputStat.st_size > INT_MAX) {
+        error("Input too large for the single-stream format (use -b)");
     }
 
-    // The input and output streams.
-    FancyInputStream* inputFile;
-    FancyOutputStream* outputFile;
-
-    // The unsigned char representation of the byte we are reading.
-    unsigned char nextChar; 
     // Vector of all possible symbols and frequency
     vector<int> symFreq(maxFreq);
-    
-    // The Huffman Tree constructed from reading file.
-    HCTree* huffTree;
-
-    // Open the input stream from the first argument of the program.
-    inputFile = new FancyInputStream(argv[1]);
 
-    // Obain a byte from the file
-    nextChar = inputFile->read<unsigned char>();
+    // The sample replaces the first pass; the encoding pass then counts
+    // the bytes exactly to report what the sample cost.
+    size_t sampled = sample ? sampleFrequencies(inputFd, symFreq) : 0;
+    vector<uint64_t> exactFreq(maxFreq);
 
-    // Read the input file until we reach the end
-    while (inputFile->good()){
+    // First pass: count every byte while the reader stage fetches the
+    // next blocks.
+    if (sampled == 0) {
+        BlockPipeline countPass(inputFd, -1);
+        countPass.run([&](BlockPipeline& pipe) {
+            uint64_t total = 0;
+            Block* block;
+            while ((block = pipe.nextInput()) != nullptr) {
 
-        //Increment the frequency at the char index
-        symFreq[nextChar]++;
+                // The input may have grown since it was checked.
+                total += block->size;
+                if (total > INT_MAX) {
+                    error("Input too large for the single-stream format "
+                          "(use -b)");
+                }
 
-        // Read the next byte.
-        nextChar = inputFile->read<unsigned char>();
+                //Increment the frequency at the char index
+                for (size_t i = 0; i < block->size; i++) {
+                    symFreq[block->data[i]]++;
+                }
+                pipe.releaseInput(block);
+            }
+        });
     }
 
     // Contruct a new Huffman Tree
-    huffTree = new HCTree();
+    HCTree* huffTree = new HCTree();
     // Build its internal node structure using the frequency table.
     huffTree->build(symFreq);
-    
-    // Open the output stream from the second argument of the program.
-    outputFile = new FancyOutputStream(argv[secondArg]);
 
-    // Serialize the tree and write it to the output stream.
-    huffTree->serialize(*outputFile);
+    // Second pass: reader -> encoder -> writer, starting again at the
+    // beginning of the input.
+    BlockPipeline encodePass(inputFd, outputFd);
+    encodePass.run([&](BlockPipeline& pipe) {
+
+        // Encoded bytes waiting to be handed to the writer.
+        vector<unsigned char> encoded;
+        BitWriter bits(encoded);
+
+        // Serialize the tree and write it to the output.
+        huffTree->serialize(bits);
+
+        Block* block;
+        while ((block = pipe.nextInput()) != nullptr) {
+
+            // Encode each symbol of the block.
+            huffTree->encodeBlock(block->data.data(), block->size, bits);
+            if (sampled != 0) {
+                for (size_t i = 0; i < block->size; i++) {
+                    exactFreq[block->data[i]]++;
+                }
+            }
+            pipe.releaseInput(block);
+
+            // Pass on full output blocks.
+            if (encoded.size() >= pipe.blockSize()) {
+                emitEncoded(pipe, encoded);
+            }
+        }
+
+        // Pad the last byte and pass on the rest of the output.
+        bits.flush();
+        if (!encoded.empty()) {
+            emitEncoded(pipe, encoded);
+        }
+    });
+
+    // Compare the bitstream against the one the exact counts would give.
+    if (sampled != 0) {
+        vector<int> exactCounts(exactFreq.begin(), exactFreq.end());
+        HCTree* exactTree = new HCTree();
+        exactTree->build(exactCounts);
+
+        uint64_t encodedBits = 0;
+        uint64_t exactBits = 0;
+        for (int b = 0; b < maxFreq; b++) {
+            encodedBits += exactFreq[b] * huffTree->codeLength(b);
+            exactBits += exactFreq[b] * exactTree->codeLength(b);
+        }
+        delete(exactTree);
+
+        fprintf(stderr, "sampled %zu bytes: %llu bytes coded, %llu with "
+                "exact counts (+%.3f%%)\n", sampled,
+                (unsigned long long)(encodedBits + 7) / 8,
+                (unsigned long long)(exactBits + 7) / 8,
+                exactBits ? 100.0 * ((double)encodedBits / exactBits - 1)
+                          : 0.0);
+    }
+
+    // Delete the tree.
+    delete(huffTree);
+}
+
+/**
+ * Compress to the block format in a single pass: every input block of the
+ * pipeline becomes one independently coded block.
+ *
+ * @param inputFd the input file
+ * @param outputFd the output file
+ * @param flags the file header flags
+ * @param options how to code each block
+ */
+static void compressBlocks(int inputFd, int outputFd, unsigned char flags,
+                           const EncodeOptions& options) {
+    BlockPipeline encodePass(inputFd, outputFd);
+
+    FileHeader header;
+    header.version = BLOCK_VERSION;
+    header.flags = flags;
+    header.blockSize = encodePass.blockSize();
+
+    // The total size goes in the header so decompress can preallocate its
+    // output; a pipe has no size up front.
+    struct stat inputStat;
+    header.totalSize = UNKNOWN_SIZE;
+    if (fstat(inputFd, &inputStat) == 0 && S_ISREG(inputStat.st_mode)) {
+        header.totalSize = inputStat.st_size;
+    }
+
+    encodePass.run([&](BlockPipeline& pipe) {
+
+        // Encoded bytes waiting to be handed to the writer.
+        vector<unsigned char> encoded;
+        writeFileHeader(header, encoded);
+
+        Block* block;
+        while ((block = pipe.nextInput()) != nullptr) {
+            encodeBlock(block->data.data(), block->size, header, encoded,
+                        options);
+            pipe.releaseInput(block);
+
+            // Pass on full output blocks.
+            if (encoded.size() >= pipe.blockSize()) {
+                emitEncoded(pipe, encoded);
+            }
+        }
 
-    // Start at the beggining of the input stream.
-    inputFile->reset();
+        writeEndBlock(header, encoded);
+        emitEncoded(pipe, encoded);
+    });
+}
 
-    // Read the next byte from the input stream.
-    nextChar = inputFile->read<unsigned char>();
-    
-    // Read the input file until we reach the end.
-    while (inputFile->good()){
-        
-        // Encode each symbol we read from the input stream,
-        // and write the huffman encoding of it to the output stream.
-        huffTree->encode(nextChar, *outputFile);
+/**
+ * Compress to the adaptive format in a single pass. Input is coded as it
+ * arrives, and the whole bytes are written right away, so a reader of a
+ * pipe sees the output of a message as soon as the message is written.
+ *
+ * @param inputFd the input file
+ * @param outputFd the output file
+ */
+static void compressAdaptive(int inputFd, int outputFd) {
+
+    // Largest chunk of input taken at once.
+    const size_t chunkSize = 64 * 1024;
 
-        // Read the next byte from the input file.
-        nextChar = inputFile->read<unsigned char>();
-    
+    AdaptiveHCTree* huffTree = new AdaptiveHCTree();
+    vector<unsigned char> input(chunkSize);
+    vector<unsigned char> encoded;
+    BitWriter bits(encoded);
+    bits.write<uint32_t>(ADAPTIVE_MAGIC);
+
+    while (true) {
+        // read() returns whatever is available instead of a full chunk.
+        ssize_t n = read(inputFd, input.data(), input.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            error("Cannot read input file\n");
+        }
+        if (n == 0) {
+            break;
+        }
+
+        for (ssize_t i = 0; i < n; i++) {
+            huffTree->encode(input[i], bits);
+        }
+        writeFully(outputFd, encoded.data(), encoded.size());
+        encoded.clear();
     }
 
-    // Write everything from the output buffer to the output file.
-    outputFile->flush();
+    // Mark the end and pad the last byte.
+    huffTree->encode(EOF_SYMBOL, bits);
+    bits.flush();
+    writeFully(outputFd, encoded.data(), encoded.size());
 
-    // Delete the tree, input stream and output stream objects.
     delete(huffTree);
-    delete(inputFile);
-    delete(outputFile);
+}
+
+/**
+ * Read the list of files for batch mode.
+ *
+ * @param listPath the list, one "input" or "input<TAB>name" per line
+ * @return the files, in list order
+ */
+static vector<BatchItem> readBatchList(const string& listPath) {
+    ifstream list(listPath.c_str());
+    if (!list) {
+        error("Cannot open list " + listPath);
+    }
+
+    vector<BatchItem> items;
+    string line;
+    while (getline(list, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        BatchItem item;
+        size_t tab = line.find('\t');
+        item.input = line.substr(0, tab);
+        item.name = tab == string::npos ? item.input : line.substr(tab + 1);
+
+        // Names are always relative to the output.
+        size_t start = item.name.find_first_not_of('/');
+        item.name.erase(0, start == string::npos ? item.name.size() : start);
+        if (!safeEntryName(item.name)) {
+            error("Unsafe output name for " + item.input);
+        }
+        items.push_back(item);
+    }
+    return items;
+}
+
+/**
+ * Compress every file of a list on a thread pool, either into a
+ * directory or into one archive.
+ *
+ * @param listPath the list of files
+ * @param outPath the output directory or archive
+ * @param toArchive true to write an archive
+ * @param blockFormat true for the block format
+ * @param flags the block format flags
+ * @param options how to code each block
+ * @param threads the number of workers, 0 for one per CPU
+ */
+static void compressBatch(const string& listPath, const string& outPath,
+                          bool toArchive, bool blockFormat,
+                          unsigned char flags, const EncodeOptions& options,
+                          size_t threads) {
+    vector<BatchItem> items = readBatchList(listPath);
+
+    ArchiveWriter* archive = nullptr;
+    if (toArchive) {
+        archive = new ArchiveWriter(outPath, items.size());
+    }
+
+    // Buffers owned by each worker, grown once and reused for every file.
+    ThreadPool pool(threads);
+    vector<vector<unsigned char> > inputs(pool.size());
+    vector<vector<unsigned char> > outputs(pool.size());
+
+    pool.run(items.size(), [&](int worker, size_t i) {
+        vector<unsigned char>& input = inputs[worker];
+        vector<unsigned char>& output = outputs[worker];
+
+        readWholeFile(items[i].input, input);
+        compressMemory(input.data(), input.size(), blockFormat, flags,
+                       output, options);
 
+        if (archive != nullptr) {
+            archive->add(i, items[i].name, output, input.size());
+        } else {
+            writeWholeFile(outPath + "/" + items[i].name, output);
+        }
+    });
+
+    if (archive != nullptr) {
+        archive->finish();
+        delete(archive);
+    }
+}
+
+/**
+ * Look up a transform by its name on the command line.
+ *
+ * @param name the name
+ * @return the transform
+ */
+static int transformByName(const string& name) {
+    const char* names[TRANSFORM_COUNT] = {
+        "none", "delta1", "delta2", "delta4", "delta8", "mtf", "planes2",
+        "planes4", "planes8"
+    };
+    if (name == "auto") {
+        return TRANSFORM_AUTO;
+    }
+    for (int t = 0; t < TRANSFORM_COUNT; t++) {
+        if (name == names[t]) {
+            return t;
+        }
+    }
+    error("Unknown transform " + name + "\n");
+    return TRANSFORM_NONE;
+}
+
+/**
+ * The Main function of the compress program, handling input
+ * argument, reading an input file and compressing it to an output file.
+ * 
+ * @param argc the number of program arguments
+ * @param argv the arguments
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main( int argc, char** argv) {
+
+    // Constants for styling purposes.
+    const int expectedArgs = 2;
+
+    // Which format to write, and its flags.
+    bool adaptive = false;
+    bool sample = false;
+    bool blockFormat = false;
+    unsigned char flags = 0;
+    EncodeOptions options;
+
+    // Batch mode options.
+    const char* listPath = nullptr;
+    bool toArchive = false;
+    size_t threads = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "bcowe:t:l:aj:As")) != -1) {
+        switch (option) {
+        case 'b':
+            blockFormat = true;
+            break;
+        case 'c':
+            blockFormat = true;
+            flags |= FLAG_CHECKSUM;
+            break;
+        case 'o':
+            blockFormat = true;
+            options.order1 = true;
+            break;
+        case 'w':
+            blockFormat = true;
+            options.wide = true;
+            break;
+        case 'e':
+            if (string(optarg) == "huffman") {
+                options.coder = CODER_HUFFMAN;
+            } else if (string(optarg) == "ans") {
+                options.coder = CODER_ANS;
+                blockFormat = true;
+            } else if (string(optarg) == "auto") {
+                options.coder = CODER_AUTO;
+                blockFormat = true;
+            } else {
+                error("Unknown coder " + string(optarg) + "\n");
+                return 1;
+            }
+            break;
+        case 't':
+            options.transform = transformByName(optarg);
+            blockFormat = true;
+            break;
+        case 'l':
+            listPath = optarg;
+            break;
+        case 'a':
+            toArchive = true;
+            break;
+        case 'j':
+            threads = strtoul(optarg, nullptr, 10);
+            break;
+        case 'A':
+            adaptive = true;
+            break;
+        case 's':
+            sample = true;
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+
+    // Batch mode takes just the output.
+    if (listPath != nullptr) {
+        if (argc - optind != 1) {
+            error("Incorrect parameters\n");
+            return 1;
+        }
+        compressBatch(listPath, argv[optind], toArchive, blockFormat, flags,
+                      options, threads);
+        return 0;
+    }
+
+    // If we don't read the correct number of arguments, display an error
+    // and return to stderr.
+    if (argc - optind != expectedArgs) {
+        error("Incorrect parameters\n");
+        return 1;
+    }
+
+    // Open the input and output files from the program arguments.
+    int inputFd = open(argv[optind], O_RDONLY);
+    if (inputFd < 0) {
+        error("Cannot open input file\n");
+        return 1;
+    }
+    int outputFd = open(argv[optind + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outputFd < 0) {
+        error("Cannot open output file\n");
+        return 1;
+    }
+
+    if (adaptive) {
+        compressAdaptive(inputFd, outputFd);
+    } else if (blockFormat) {
+        compressBlocks(inputFd, outputFd, flags, options);
+    } else {
+        compressStream(inputFd, outputFd, sample);
+    }
 
-}
\ No newline at end of file
+    close(inputFd);
+    close(outputFd);
+}
@@ -9,86 +9,647 @@
  * the input arguments, constructing a Huffamn Tree object and manipulation
  * of the Tree functions to accomplish this. This assumes that the compressed
  * file is written in the format: totalFrequency, serialization, encodings.
+ * Reading and decoding overlap through a BlockPipeline. Since the header
+ * gives the exact output size, a regular output file is preallocated and
+ * memory mapped, and the decoder stores the symbols straight into it.
+ * Files in the block format (see BlockFormat.hpp) are recognized by their
+ * magic number and decoded block by block, verifying checksums if present.
+ *
+ * Files in the adaptive format (see AdaptiveHCTree.hpp) are decoded as
+ * their bytes arrive and written out chunk by chunk.
+ * Large single-stream files that are regular files on both ends are
+ * decoded on all cores instead (see ParallelDecode.hpp), and so are large
+ * block format files with a block index (such as transcode writes), one
+ * block per worker at a time.
+ *
+ * With -m the input is streamed through a pipeline sized to a memory
+ * ceiling, whatever the size of the input: no mappings, no parallel
+ * decode, and block format files whose blocks would not fit are rejected
+ * up front. The peak resident memory is reported on stderr at the end.
+ * Either file may be given as "-" for stdin or stdout, so
+ *
+ *   ... | decompress -m 16M - - | ...
+ *
+ * decodes an unbounded stream in a fixed amount of memory.
+ *
+ * Usage: decompress [-j threads] [-m limit] infile outfile
+ *        decompress [-j threads] -x archive outdir
+ *   -x  extract every entry of an archive written by compress -a into
+ *       outdir, decompressing them on a thread pool
+ *   -j  number of decoding or extraction threads (default: one per CPU;
+ *       -j 1 decodes single-stream files sequentially)
+ *   -m  stream in at most limit bytes of memory (K, M or G suffix); at
+ *       least 4.5M, and 4.25M plus 3 times the block size for block format
+ *       files (8M is enough for the default 1M blocks)
  */
 
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "AdaptiveHCTree.hpp"
+#include "Archive.hpp"
+#include "BlockFormat.hpp"
+#include "Codec.hpp"
 #include "HCTree.hpp"
 #include "Helper.hpp"
+#include "MappedFile.hpp"
+#include "ParallelDecode.hpp"
+#include "Pipeline.hpp"
+#include "ThreadPool.hpp"
+
+// Memory a streaming decompress (-m) needs besides its buffers: the
+// program, the C++ runtime, thread stacks and the decoding tables.
+static const size_t STREAM_OVERHEAD = 4 << 20;
+
+// Bounds on the input block size of a streaming decompress.
+static const size_t STREAM_MIN_BLOCK = 64 << 10;
+static const size_t STREAM_MAX_BLOCK = 1 << 20;
+
+// Blocks in flight in each direction of a streaming decompress.
+static const size_t STREAM_DEPTH = 2;
+
+/**
+ * Print the peak resident memory of the process to stderr.
+ *
+ * @param limit the memory ceiling it ran under
+ */
+static void reportPeakMemory(size_t limit) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    // ru_maxrss is in KiB on Linux.
+    fprintf(stderr, "peak memory: %.1f MiB (limit %.1f MiB)\n",
+            usage.ru_maxrss / 1024.0, limit / 1048576.0);
+}
+
+/**
+ * Read until buf is full or the input ends.
+ *
+ * @param fd the file to read from
+ * @param buf where to read to
+ * @param len how many bytes to read
+ * @return the number of bytes read
+ */
+static size_t readPrefix(int fd, unsigned char* buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = read(fd, buf + done, len - done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * Decode the single-stream format: totalFrequency, serialization,
+ * encodings.
+ *
+ * @param bits the input, positioned after the total frequency
+ * @param totalFreq the total frequency read from the header
+ * @param treeLimit bound on the size of the serialized tree
+ * @param pipe the pipeline (for its writer stage)
+ * @param outputFd the output file, or -1 to use the writer stage
+ * @param inputSize the size of the whole input (known if outputFd >= 0)
+ */
+static void decompressStream(BitReader& bits, int totalFreq, int treeLimit,
+                             BlockPipeline& pipe, int outputFd,
+                             uint64_t inputSize) {
+
+    // Block and adaptive files start with a negative magic number; any
+    // other negative count is corrupt.
+    if (totalFreq < 0) {
+        error("Corrupt input");
+    }
+
+    // The Huffman Tree constructed from reading the file.
+    HCTree* huffTree = new HCTree();
+
+    // Deserialize the tree from the header of the compressed file.
+    huffTree->deserialize(treeLimit, bits);
+
+    if (outputFd >= 0) {
+        // Preallocate the output to its known size, once the input is
+        // known to be large enough for it, and decode into it.
+        if (totalFreq > 0 &&
+            (!bits.good() ||
+             !huffTree->countFits(totalFreq, inputSize * 8 - min<uint64_t>(
+                                      bits.position(), inputSize * 8)))) {
+            error("Corrupt input");
+        }
+        MappedFile output(outputFd, totalFreq, true);
+        huffTree->decodeBlock(bits, output.data(), output.size());
+        if (totalFreq > 0 && !bits.good()) {
+            error("Corrupt input");
+        }
+    } else {
+        // Decode the symbols a whole output block at a time.
+        size_t remaining = totalFreq;
+        while (remaining > 0) {
+            Block* block = pipe.acquireOutput();
+            size_t count = min(remaining, block->data.size());
+            huffTree->decodeBlock(bits, block->data.data(), count);
+
+            // Stop as soon as the input runs out, instead of decoding
+            // the rest of a corrupt count from nothing.
+            if (!bits.good()) {
+                error("Corrupt input");
+            }
+            block->size = count;
+            pipe.emitOutput(block);
+            remaining -= count;
+        }
+    }
+
+    //Delete the tree.
+    delete(huffTree);
+}
 
 /**
- * The Main function of the compress program, handling input
- * argument, reading an input file and compressing it to an output file.
- * 
+ * Decode the single-stream format on a thread pool, with both the input
+ * and the output memory mapped.
+ *
+ * @param inputFd the input file
+ * @param inputSize its size
+ * @param outputFd the output file
+ * @param treeLimit bound on the size of the serialized tree
+ * @param threads the number of workers, 0 for one per CPU
+ */
+static void decompressParallel(int inputFd, size_t inputSize, int outputFd,
+                               int treeLimit, size_t threads) {
+    MappedFile input(inputFd, inputSize, false);
+    BitReader bits(input.data(), input.size());
+
+    // Read the total symbol frequency and the tree.
+    int totalFreq = bits.read<int>();
+    if (totalFreq < 0) {
+        error("Corrupt input");
+    }
+    HCTree* huffTree = new HCTree();
+    huffTree->deserialize(treeLimit, bits);
+    if (!bits.good() ||
+        !huffTree->countFits(totalFreq, input.size() * 8 - bits.position())) {
+        error("Corrupt input");
+    }
+
+    // Preallocate the output and decode the bitstream after the tree.
+    MappedFile output(outputFd, totalFreq, true);
+    ThreadPool pool(threads);
+    if (!parallelDecode(*huffTree, input.data(), input.size(),
+                        bits.position(), output.data(), output.size(),
+                        pool)) {
+        error("Corrupt input");
+    }
+
+    //Delete the tree.
+    delete(huffTree);
+}
+
+/**
+ * Decode an indexed block format file on a thread pool, with both the
+ * input and the output memory mapped. Every block is found through the
+ * index and decoded straight to its place in the output.
+ *
+ * @param inputFd the input file
+ * @param inputSize its size
+ * @param outputFd the output file
+ * @param header the file header (with FLAG_INDEX and a known total size)
+ * @param threads the number of workers, 0 for one per CPU
+ */
+static void decompressIndexed(int inputFd, size_t inputSize, int outputFd,
+                              const FileHeader& header, size_t threads) {
+    MappedFile input(inputFd, inputSize, false);
+    vector<BlockIndexEntry> index;
+    uint64_t indexOffset = readBlockIndex(input.data(), input.size(), header,
+                                          index);
+
+    MappedFile output(outputFd, header.totalSize, true);
+    ThreadPool pool(threads);
+    pool.run(index.size(), [&](int, size_t i) {
+
+        // The block must fit in the space up to the next one.
+        uint64_t end = i + 1 < index.size() ? index[i + 1].offset
+                                            : indexOffset;
+        uint64_t rawEnd = i + 1 < index.size() ? index[i + 1].rawOffset
+                                               : header.totalSize;
+        BitReader bits(input.data() + index[i].offset,
+                       end - index[i].offset);
+        BlockHeader block;
+        if (!readBlockHeader(bits, header, block)) {
+            error("Corrupt block index");
+        }
+        uint64_t payloadOffset = index[i].offset + bits.position() / 8;
+        if (block.rawSize != rawEnd - index[i].rawOffset ||
+            block.payloadSize > end - payloadOffset) {
+            error("Corrupt block index");
+        }
+        decodeBlock(header, block, input.data() + payloadOffset,
+                    output.data() + index[i].rawOffset);
+    });
+}
+
+/**
+ * Decode the adaptive format, writing out every chunk of input as soon
+ * as it is decoded.
+ *
+ * @param inputFd the input file, positioned after the magic number
+ * @param outputFd the output file
+ */
+static void decompressAdaptive(int inputFd, int outputFd) {
+
+    // Largest chunk of input taken at once.
+    const size_t chunkSize = 64 * 1024;
+
+    AdaptiveHCTree* huffTree = new AdaptiveHCTree();
+    vector<unsigned char> input(chunkSize);
+    vector<unsigned char> decoded;
+
+    bool done = false;
+    while (!done) {
+        // read() returns whatever is available instead of a full chunk.
+        ssize_t n = read(inputFd, input.data(), input.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error("Truncated input");
+        }
+
+        // Feed the decoder bit by bit, MSB first, until the end symbol.
+        for (ssize_t i = 0; i < n && !done; i++) {
+            for (int b = 7; b >= 0; b--) {
+                int sym = huffTree->decodeBit((input[i] >> b) & 1);
+                if (sym == EOF_SYMBOL) {
+                    done = true;
+                    break;
+                }
+                if (sym >= 0) {
+                    decoded.push_back(sym);
+                }
+            }
+        }
+        writeFully(outputFd, decoded.data(), decoded.size());
+        decoded.clear();
+    }
+
+    delete(huffTree);
+}
+
+/**
+ * Decode the block format.
+ *
+ * @param bits the input, positioned after the file header
+ * @param header the file header
+ * @param pipe the pipeline (for its writer stage)
+ * @param outputFd the output file to map, or -1 to use the writer stage
+ * @param chunked whether to pass each block to the writer stage in pieces
+ *                of the pipeline's block size, so the output blocks stay
+ *                that small (for -m)
+ */
+static void decompressBlocks(BitReader& bits, const FileHeader& header,
+                             BlockPipeline& pipe, int outputFd,
+                             bool chunked) {
+
+    // Preallocate the output to its known size and decode into it.
+    MappedFile* output = nullptr;
+    if (outputFd >= 0) {
+        output = new MappedFile(outputFd, header.totalSize, true);
+    }
+    uint64_t written = 0;
+
+    BlockHeader block;
+    vector<unsigned char> payload;
+    vector<unsigned char> decoded;
+    while (readBlockHeader(bits, header, block)) {
+        payload.resize(block.payloadSize);
+        bits.readBytes(payload.data(), block.payloadSize);
+        if (!bits.good()) {
+            error("Truncated block");
+        }
+
+        if (output != nullptr) {
+            if (block.rawSize > output->size() - written) {
+                error("Corrupt block header");
+            }
+            decodeBlock(header, block, payload.data(),
+                        output->data() + written);
+        } else if (chunked) {
+            decoded.resize(block.rawSize);
+            decodeBlock(header, block, payload.data(), decoded.data());
+            for (size_t offset = 0; offset < block.rawSize;) {
+                Block* out = pipe.acquireOutput();
+                out->size = min<size_t>(pipe.blockSize(),
+                                        block.rawSize - offset);
+                if (out->data.size() < out->size) {
+                    out->data.resize(out->size);
+                }
+                memcpy(out->data.data(), decoded.data() + offset, out->size);
+                offset += out->size;
+                pipe.emitOutput(out);
+            }
+        } else {
+            Block* out = pipe.acquireOutput();
+            if (out->data.size() < block.rawSize) {
+                out->data.resize(block.rawSize);
+            }
+            decodeBlock(header, block, payload.data(), out->data.data());
+            out->size = block.rawSize;
+            pipe.emitOutput(out);
+        }
+        written += block.rawSize;
+    }
+
+    delete(output);
+    if (header.totalSize != UNKNOWN_SIZE && written != header.totalSize) {
+        error("Truncated input");
+    }
+}
+
+/**
+ * Extract every entry of an archive on a thread pool.
+ *
+ * @param archivePath the archive
+ * @param outPath the directory to extract to
+ * @param threads the number of workers, 0 for one per CPU
+ */
+static void extractArchive(const string& archivePath, const string& outPath,
+                           size_t threads) {
+    ArchiveReader archive(archivePath);
+    const vector<ArchiveEntry>& entries = archive.list();
+
+    // Buffers owned by each worker, grown once and reused for every entry.
+    ThreadPool pool(threads);
+    vector<vector<unsigned char> > inputs(pool.size());
+    vector<vector<unsigned char> > outputs(pool.size());
+
+    pool.run(entries.size(), [&](int worker, size_t i) {
+        vector<unsigned char>& input = inputs[worker];
+        vector<unsigned char>& output = outputs[worker];
+
+        archive.read(entries[i], input);
+        decompressMemory(input.data(), input.size(), output,
+                         entries[i].originalSize);
+        if (output.size() != entries[i].originalSize) {
+            error("Size mismatch in " + entries[i].name);
+        }
+        writeWholeFile(outPath + "/" + entries[i].name, output);
+    });
+}
+
+/**
+ * Handle the input arguments, and decompress the input file to the output
+ * file (or extract an archive).
+ *
  * @param argc the number of program arguments
  * @param argv the arguments
- * @return 0 if program successful, otherwise stderr.
+ * @param createdPath set to the output file once it has been created
+ * @return 0 if program successful
  */
-int main( int argc, char** argv) {
+static int decompressMain(int argc, char** argv, string& createdPath) {
+
+    const int expectedArgs = 2;
 
-    const int expectedArgs = 3;
-    const int secondArg = 2;
+    // Archive extraction options.
+    const char* archivePath = nullptr;
+    size_t threads = 0;
+
+    // Memory ceiling of a streaming decompress, 0 for none.
+    size_t memoryLimit = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "x:j:m:")) != -1) {
+        switch (option) {
+        case 'x':
+            archivePath = optarg;
+            break;
+        case 'j':
+            threads = strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            memoryLimit = parseSize(optarg);
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+
+    // Extraction takes just the output directory.
+    if (archivePath != nullptr) {
+        if (argc - optind != 1) {
+            error("Incorrect parameters\n");
+            return 1;
+        }
+        extractArchive(archivePath, argv[optind], threads);
+        return 0;
+    }
 
     // If we don't read the correct number of arguments, display an error
     // and return to stderr.
-    if (argc != expectedArgs) {
+    if (argc - optind != expectedArgs) {
         error("Incorrect parameters\n");
         return 1;
     }
 
-    // The input and output streams.
-    FancyInputStream* inputFile;
-    FancyOutputStream* outputFile;
-    // The Huffman Tree constructed from reading the file.
-    HCTree* huffTree;
+    // Split the memory ceiling into the buffers and everything else. Half
+    // of the buffers go to the pipeline's input and output blocks.
+    size_t streamBlock = BlockPipeline::DEFAULT_BLOCK_SIZE;
+    size_t streamDepth = BlockPipeline::DEFAULT_DEPTH;
+    size_t bufferLimit = 0;
+    if (memoryLimit != 0) {
+        if (memoryLimit < STREAM_OVERHEAD + 8 * STREAM_MIN_BLOCK) {
+            error("Memory limit too low");
+        }
+        bufferLimit = memoryLimit - STREAM_OVERHEAD;
+        streamBlock = min(STREAM_MAX_BLOCK, bufferLimit / (4 * STREAM_DEPTH));
+        streamDepth = STREAM_DEPTH;
+    }
 
-    // Open the input and output streams by using the input arguments.
-    inputFile = new FancyInputStream(argv[1]);
-    outputFile = new FancyOutputStream(argv[secondArg]);
+    // Open the input and output files by using the input arguments ("-"
+    // for stdin and stdout).
+    string inputPath = argv[optind];
+    string outputPath = argv[optind + 1];
+    int inputFd = inputPath == "-" ? STDIN_FILENO
+                                   : open(inputPath.c_str(), O_RDONLY);
+    if (inputFd < 0) {
+        error("Cannot open input file\n");
+        return 1;
+    }
+    int outputFd = outputPath == "-"
+                       ? STDOUT_FILENO
+                       : open(outputPath.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                              0644);
+    if (outputFd < 0) {
+        error("Cannot open output file\n");
+        return 1;
+    }
+    if (outputPath != "-") {
+        createdPath = outputPath;
+    }
+
+    // Get the file size of the input (unknown for pipes).
+    struct stat inputStat;
+    long inputfilesize = LONG_MAX;
+    if (fstat(inputFd, &inputStat) == 0 && S_ISREG(inputStat.st_mode)) {
+        inputfilesize = inputStat.st_size;
+    }
+    int treeLimit = (int)min<long>(inputfilesize - (long)sizeof(int), INT_MAX);
 
-    // Get the file size of the input stream.
-    int inputfilesize = inputFile->filesize();
+    // Decode into a mapping of the output file if it is a regular file,
+    // otherwise (pipes, devices) through the writer stage.
+    struct stat outputStat;
+    // A streaming decompress never maps the output, whose pages would count
+    // against the ceiling. Nor is a stdout the shell opened write-only
+    // mapped, since a shared mapping needs read access too.
+    bool mapOutput = memoryLimit == 0 && fstat(outputFd, &outputStat) == 0 &&
+                     S_ISREG(outputStat.st_mode) &&
+                     (fcntl(outputFd, F_GETFL) & O_ACCMODE) == O_RDWR;
 
-    // Read the total symbol frequency from the header of the compressed
-    // file.
-    int totalFreq = inputFile->read<int>();
+    // Read the start of the file to see which format it is in; the
+    // pipeline carries on reading right after it.
+    // Only the magic number is read up front, so a stream that has just
+    // started is not held up waiting for a whole file header.
+    unsigned char prefix[FILE_HEADER_SIZE];
+    size_t prefixSize = readPrefix(inputFd, prefix, sizeof(uint32_t));
 
-    // Construct a new Huffman Tree
-    huffTree = new HCTree();
-    
-    // Deserialize the tree by reading from the input stream
-    // of the compressed file.
-    huffTree->deserialize(inputfilesize - sizeof(int), *inputFile);
+    BitReader magicBits(prefix, prefixSize);
+    uint32_t magic = magicBits.read<uint32_t>();
+    bool blockFormat = magic == BLOCK_MAGIC && magicBits.good();
 
-    //How many symbols have been decoded.
-    int counter = 0;
+    if (magic == ADAPTIVE_MAGIC && magicBits.good()) {
+        decompressAdaptive(inputFd, outputFd);
+        close(inputFd);
+        close(outputFd);
+        if (memoryLimit != 0) {
+            reportPeakMemory(memoryLimit);
+        }
+        return 0;
+    }
 
-    if (!inputFile->good()) {
-        totalFreq = 0;
+    // A single stream is only decoded into a preallocated output when the
+    // input size can bound its count first.
+    if (!blockFormat && inputfilesize == LONG_MAX) {
+        mapOutput = false;
     }
-    
-    // while the number of symbols read is less than the total symbol freq.
-    while (counter < totalFreq) {
 
-        // The character to be decoded.
-        unsigned char decodedChar;
+    FileHeader header;
+    if (blockFormat) {
+        prefixSize += readPrefix(inputFd, prefix + prefixSize,
+                                 sizeof(prefix) - prefixSize);
+        BitReader prefixBits(prefix, prefixSize);
+        prefixBits.read<uint32_t>();
+        header = readFileHeader(prefixBits);
 
-        // Decode a character from the input stream, and write it
-        // to the output stream.
-        decodedChar = huffTree->decode(*inputFile);
-        outputFile->write<char>(decodedChar);
+        // Without a known total size the output can not be preallocated.
+        if (header.totalSize == UNKNOWN_SIZE) {
+            mapOutput = false;
+        }
 
-        // Increment the symbol counter by one.
-        counter++;
+        // Decoding a block takes its payload, the decoded block and a
+        // transform buffer, all up to the block size; the pipeline's blocks
+        // get what is left, shrunk if need be.
+        if (memoryLimit != 0) {
+            size_t decodeBytes = 3 * (size_t)header.blockSize;
+            if (decodeBytes + 2 * streamDepth * STREAM_MIN_BLOCK >
+                bufferLimit) {
+                error("Block size exceeds the memory limit");
+            }
+            streamBlock = min(streamBlock, (bufferLimit - decodeBytes) /
+                                               (2 * streamDepth));
+        }
     }
 
-    // Write everything from the output stream to the file itself.
-    outputFile->flush();
+    // A large single stream between two regular files is decoded in
+    // parallel from mappings of both.
+    if (!blockFormat && mapOutput && inputfilesize != LONG_MAX &&
+        (size_t)inputfilesize >= PARALLEL_MIN_SIZE && threads != 1) {
+        decompressParallel(inputFd, inputfilesize, outputFd, treeLimit,
+                           threads);
+        close(inputFd);
+        close(outputFd);
+        return 0;
+    }
 
-    //Delete the tree, the input and output streams.
-    delete(huffTree);
-    delete(inputFile);
-    delete(outputFile);
-}
\ No newline at end of file
+    // So is an indexed block file.
+    if (blockFormat && (header.flags & FLAG_INDEX) && mapOutput &&
+        inputfilesize != LONG_MAX &&
+        (size_t)inputfilesize >= PARALLEL_MIN_SIZE && threads != 1) {
+        decompressIndexed(inputFd, inputfilesize, outputFd, header, threads);
+        close(inputFd);
+        close(outputFd);
+        return 0;
+    }
+
+    // reader -> decoder (-> writer)
+    BlockPipeline decodePass(inputFd, mapOutput ? -1 : outputFd, streamBlock,
+                             streamDepth);
+    decodePass.run([&](BlockPipeline& pipe) {
+
+        if (blockFormat) {
+            BitReader bits(nullptr, 0, &pipe);
+            decompressBlocks(bits, header, pipe, mapOutput ? outputFd : -1,
+                             memoryLimit != 0);
+            return;
+        }
+
+        // Read bits straight across the prefix and the input blocks.
+        BitReader bits(prefix, prefixSize, &pipe);
+
+        // Read the total symbol frequency from the header of the
+        // compressed file.
+        int totalFreq = bits.read<int>();
+
+        if (!bits.good()) {
+            return;
+        }
+
+        decompressStream(bits, totalFreq, treeLimit, pipe,
+                         mapOutput ? outputFd : -1, inputfilesize);
+    });
+
+    // Close the files.
+    close(inputFd);
+    close(outputFd);
+
+    if (memoryLimit != 0) {
+        reportPeakMemory(memoryLimit);
+    }
+    return 0;
+}
+
+/**
+ * The Main function of the decompress program. Errors, corrupt input
+ * included, are printed to stderr, and a partly written output file is
+ * removed.
+ *
+ * @param argc the number of program arguments
+ * @param argv the arguments
+ * @return 0 if program successful, otherwise 1.
+ */
+int main(int argc, char** argv) {
+    string createdPath;
+    try {
+        return decompressMain(argc, argv, createdPath);
+    } catch (const exception& e) {
+        string message = e.what();
+        while (!message.empty() && message.back() == '\n') {
+            message.pop_back();
+        }
+        cerr << "decompress: " << message << endl;
+        if (!createdPath.empty()) {
+            unlink(createdPath.c_str());
+        }
+        return 1;
+    }
+}
@@ -0,0 +1,274 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides gencorpus, a generator of synthetic inputs for the
+ * benchmark. The example files are friendly text; these are the shapes
+ * that stress the coder instead:
+ *
+ *   zipf       symbol k (in a shuffled order) has probability ~ 1/k^s
+ *   fibonacci  symbol counts are consecutive Fibonacci numbers, which
+ *              gives the deepest possible tree for the file size
+ *   uniform    all 256 symbols equally likely, so every code is ~8 bits
+ *   bursty     runs that switch between a repeated byte, a small local
+ *              alphabet, text-like Zipf and uniform noise
+ *   single     one symbol repeated
+ *
+ * Everything is drawn from a seeded mt19937_64, and only its raw output is
+ * used (no std:: distributions, whose results differ between standard
+ * libraries), so a seed and a size give the same bytes everywhere.
+ *
+ * Usage: gencorpus [-s seed] [-n size] [-z exponent] distribution outfile
+ *   -s  seed of the generator (default 1)
+ *   -n  size of the output, with an optional K, M or G suffix
+ *       (default 1M)
+ *   -z  Zipf exponent (default 1.0)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Codec.hpp"
+#include "Helper.hpp"
+
+// Longest run of the bursty distribution.
+static const size_t MAX_BURST = 4096;
+
+/**
+ * Uniform integer in [0, bound).
+ *
+ * @param rng the generator
+ * @param bound the (exclusive) upper bound
+ * @return the integer
+ */
+static size_t below(mt19937_64& rng, size_t bound) {
+    return rng() % bound;
+}
+
+/**
+ * Uniform double in [0, 1).
+ *
+ * @param rng the generator
+ * @return the double
+ */
+static double unit(mt19937_64& rng) {
+    return (rng() >> 11) * (1.0 / (1ull << 53));
+}
+
+/**
+ * Shuffle the first count elements of data (Fisher-Yates).
+ *
+ * @param rng the generator
+ * @param data the elements
+ * @param count how many of them
+ */
+template<typename T>
+static void shuffleFirst(mt19937_64& rng, T* data, size_t count) {
+    for (size_t i = count; i > 1; i--) {
+        swap(data[i - 1], data[below(rng, i)]);
+    }
+}
+
+/**
+ * Sampler of a Zipf distribution over the 256 byte values, in a shuffled
+ * order so the frequent symbols are not just the small byte values.
+ */
+struct ZipfSampler {
+    vector<double> cumulative;
+    vector<unsigned char> symbols;
+
+    /**
+     * @param rng the generator (to shuffle the symbols)
+     * @param exponent the Zipf exponent
+     * @param alphabet how many symbols take part (1 to 256)
+     */
+    ZipfSampler(mt19937_64& rng, double exponent, size_t alphabet) {
+        symbols.resize(256);
+        for (size_t s = 0; s < 256; s++) {
+            symbols[s] = s;
+        }
+        shuffleFirst(rng, symbols.data(), symbols.size());
+
+        double total = 0;
+        for (size_t k = 1; k <= alphabet; k++) {
+            total += 1 / pow((double)k, exponent);
+            cumulative.push_back(total);
+        }
+        for (double& c : cumulative) {
+            c /= total;
+        }
+    }
+
+    /**
+     * @param rng the generator
+     * @return the next symbol
+     */
+    unsigned char next(mt19937_64& rng) {
+        size_t rank = upper_bound(cumulative.begin(), cumulative.end(),
+                                  unit(rng)) - cumulative.begin();
+        return symbols[min(rank, cumulative.size() - 1)];
+    }
+};
+
+/**
+ * Fill out with symbols whose counts are consecutive Fibonacci numbers
+ * (1, 1, 2, 3, 5, ...), as many as fit, with the rest of the size added
+ * to the most frequent symbol, in shuffled positions. Each Fibonacci
+ * count just exceeds the sum of all smaller ones, so every merge of the
+ * Huffman algorithm takes the tree built so far and one new leaf.
+ *
+ * @param rng the generator
+ * @param out the output (its size is the file size)
+ */
+static void fillFibonacci(mt19937_64& rng, vector<unsigned char>& out) {
+    vector<size_t> counts;
+    size_t a = 1;
+    size_t b = 1;
+    size_t used = 0;
+    while (counts.size() < 256 && used + a <= out.size()) {
+        counts.push_back(a);
+        used += a;
+        size_t next = a + b;
+        a = b;
+        b = next;
+    }
+    if (counts.empty()) {
+        return;
+    }
+    counts.back() += out.size() - used;
+
+    vector<unsigned char> symbols(256);
+    for (size_t s = 0; s < 256; s++) {
+        symbols[s] = s;
+    }
+    shuffleFirst(rng, symbols.data(), symbols.size());
+
+    size_t pos = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        fill(out.begin() + pos, out.begin() + pos + counts[i], symbols[i]);
+        pos += counts[i];
+    }
+    shuffleFirst(rng, out.data(), out.size());
+}
+
+/**
+ * Fill out with bursts, each drawn from one of four local sources.
+ *
+ * @param rng the generator
+ * @param exponent the Zipf exponent of the text-like bursts
+ * @param out the output (its size is the file size)
+ */
+static void fillBursty(mt19937_64& rng, double exponent,
+                       vector<unsigned char>& out) {
+    ZipfSampler text(rng, exponent, 256);
+
+    size_t pos = 0;
+    while (pos < out.size()) {
+        size_t length = min(out.size() - pos, 1 + below(rng, MAX_BURST));
+        unsigned char* burst = out.data() + pos;
+
+        switch (below(rng, 4)) {
+        case 0: {
+            // A repeated byte.
+            fill(burst, burst + length, (unsigned char)below(rng, 256));
+            break;
+        }
+        case 1: {
+            // A few symbols, equally likely.
+            unsigned char local[16];
+            size_t alphabet = 2 + below(rng, 15);
+            for (size_t i = 0; i < alphabet; i++) {
+                local[i] = below(rng, 256);
+            }
+            for (size_t i = 0; i < length; i++) {
+                burst[i] = local[below(rng, alphabet)];
+            }
+            break;
+        }
+        case 2: {
+            // Text-like.
+            for (size_t i = 0; i < length; i++) {
+                burst[i] = text.next(rng);
+            }
+            break;
+        }
+        default: {
+            // Noise.
+            for (size_t i = 0; i < length; i++) {
+                burst[i] = below(rng, 256);
+            }
+            break;
+        }
+        }
+        pos += length;
+    }
+}
+
+/**
+ * The Main function of the generator.
+ *
+ * @param argc the number of program arguments
+ * @param argv the program arguments
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main(int argc, char** argv) {
+    uint64_t seed = 1;
+    size_t size = 1 << 20;
+    double exponent = 1.0;
+
+    int option;
+    while ((option = getopt(argc, argv, "s:n:z:")) != -1) {
+        switch (option) {
+        case 's':
+            seed = strtoull(optarg, nullptr, 10);
+            break;
+        case 'n':
+            size = parseSize(optarg);
+            break;
+        case 'z':
+            exponent = strtod(optarg, nullptr);
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        error("Incorrect parameters\n");
+        return 1;
+    }
+    string distribution = argv[optind];
+
+    mt19937_64 rng(seed);
+    vector<unsigned char> out(size);
+
+    if (distribution == "zipf") {
+        ZipfSampler zipf(rng, exponent, 256);
+        for (unsigned char& c : out) {
+            c = zipf.next(rng);
+        }
+    } else if (distribution == "fibonacci") {
+        fillFibonacci(rng, out);
+    } else if (distribution == "uniform") {
+        for (unsigned char& c : out) {
+            c = below(rng, 256);
+        }
+    } else if (distribution == "bursty") {
+        fillBursty(rng, exponent, out);
+    } else if (distribution == "single") {
+        fill(out.begin(), out.end(), (unsigned char)below(rng, 256));
+    } else {
+        error("Unknown distribution " + distribution);
+        return 1;
+    }
+
+    writeWholeFile(argv[optind + 1], out);
+    return 0;
+}
@@ -0,0 +1,406 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: unix(7) and poll(2) man pages.
+ *
+ * This file provides huffd, a long-running compression service on a Unix
+ * domain socket (see Service.hpp for the protocol). Starting a process per
+ * request pays for process startup, buffers and trees every time; the
+ * service pays once. The main thread waits on the listening socket and all
+ * idle connections, and queues a connection as soon as a request arrives
+ * on it. Worker threads take connections off the queue, serve one request
+ * each with buffers they keep from request to request, and hand the
+ * connection back. Huffman trees come from a shared cache keyed by the
+ * histogram signature of each block (see TreeCache.hpp), so blocks that
+ * look alike skip the tree build.
+ *
+ * A worker gives a request REQUEST_TIMEOUT_SECONDS from when it starts
+ * reading it to arrive in full, and its reply as long to be taken;
+ * either deadline covers the whole message, so a peer that trickles
+ * bytes or stops reading is dropped instead of pinning the worker.
+ *
+ * The metrics (OP_STATS) are the request and error counts, the current
+ * and largest queue depth, the cache counters, and the median and 99th
+ * percentile latency (queueing included) of the last LATENCY_WINDOW
+ * requests.
+ *
+ * Usage: huffd [-j threads] [-t trees] [-c] socket
+ *   -j  number of worker threads (default: one per CPU)
+ *   -t  number of trees to cache (default 256, 0 builds every tree)
+ *   -c  protect every compressed block with a CRC32C checksum
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "BlockFormat.hpp"
+#include "Codec.hpp"
+#include "Helper.hpp"
+#include "MappedFile.hpp"
+#include "Service.hpp"
+#include "TreeCache.hpp"
+
+// Number of recent latencies the percentiles are taken over.
+static const size_t LATENCY_WINDOW = 4096;
+
+// How long a worker gives a whole request to arrive, and a whole reply to
+// be taken, before it drops the connection.
+static const int REQUEST_TIMEOUT_SECONDS = 10;
+
+// Set by the signal handler to shut down.
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * A connection with a request waiting, and when it was noticed.
+ */
+struct Job {
+    int sock;
+    chrono::steady_clock::time_point queued;
+};
+
+/**
+ * Everything the main thread and the workers share.
+ */
+struct ServerState {
+    EncodeOptions options;
+    unsigned char flags;
+    TreeCache* cache;      // nullptr if trees are not cached
+
+    // Wakes the main thread up when a worker hands a connection back.
+    int wakePipe[2];
+
+    // Protected by lock.
+    mutex lock;
+    condition_variable ready;
+    deque<Job> jobs;           // connections waiting for a worker
+    vector<int> returned;      // connections handed back by workers
+    size_t connections;        // open connections
+    size_t maxQueueDepth;
+    uint64_t requests;
+    uint64_t failures;         // requests answered with an error
+    vector<double> latencies;  // ring of the last LATENCY_WINDOW, in us
+    size_t nextLatency;
+};
+
+/**
+ * Signal handler for SIGINT and SIGTERM.
+ */
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+/**
+ * @param sorted latencies in increasing order (not empty)
+ * @param fraction which percentile, from 0 to 1
+ * @return the latency at that percentile
+ */
+static double percentile(const vector<double>& sorted, double fraction) {
+    size_t rank = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+/**
+ * Format the metrics as "name value" lines.
+ *
+ * @param state the server state
+ * @return the text
+ */
+static string formatStats(ServerState& state) {
+    vector<double> sorted;
+    ostringstream text;
+    {
+        lock_guard<mutex> guard(state.lock);
+        sorted = state.latencies;
+        text << "requests " << state.requests << "\n"
+             << "errors " << state.failures << "\n"
+             << "connections " << state.connections << "\n"
+             << "queue_depth " << state.jobs.size() << "\n"
+             << "max_queue_depth " << state.maxQueueDepth << "\n";
+    }
+    if (state.cache != nullptr) {
+        text << "cache_trees " << state.cache->size() << "\n"
+             << "cache_hits " << state.cache->hits() << "\n"
+             << "cache_misses " << state.cache->misses() << "\n";
+    }
+    sort(sorted.begin(), sorted.end());
+    if (!sorted.empty()) {
+        text << "latency_p50_us " << percentile(sorted, 0.50) << "\n"
+             << "latency_p99_us " << percentile(sorted, 0.99) << "\n";
+    }
+    return text.str();
+}
+
+/**
+ * Serve one request on a connection.
+ *
+ * @param state the server state
+ * @param sock the connection
+ * @param input buffer for inline request data (reused)
+ * @param output buffer for the reply data (reused)
+ * @return false if the connection is done
+ */
+static bool serveRequest(ServerState& state, int sock,
+                         vector<unsigned char>& input,
+                         vector<unsigned char>& output) {
+    ServiceMessage msg;
+    if (!receiveMessage(sock, msg, input, REQUEST_TIMEOUT_SECONDS)) {
+        return false;
+    }
+
+    // Shared data is mapped instead of copied.
+    FdGuard passed(msg.fd);
+    MappedFile* shared = nullptr;
+    const unsigned char* data = input.data();
+
+    unsigned char status = STATUS_OK;
+    try {
+        if (msg.fd >= 0) {
+            shared = mapSharedBuffer(msg);
+            data = shared->data();
+        }
+
+        if (msg.code == OP_COMPRESS) {
+            compressMemory(data, msg.size, true, state.flags, output,
+                           state.options);
+        } else if (msg.code == OP_DECOMPRESS) {
+            decompressMemory(data, msg.size, output,
+                             MAX_DECOMPRESSED_SIZE);
+        } else if (msg.code == OP_STATS) {
+            string text = formatStats(state);
+            output.assign(text.begin(), text.end());
+        } else {
+            error("Unknown operation");
+        }
+    } catch (const exception& e) {
+        // A bad request gets an error reply; the connection stays open.
+        status = STATUS_ERROR;
+        output.assign(e.what(), e.what() + strlen(e.what()));
+    }
+    delete(shared);
+
+    bool sent = sendMessage(sock, status, output.data(), output.size(),
+                            msg.flags & MESSAGE_FD, REQUEST_TIMEOUT_SECONDS);
+
+    lock_guard<mutex> guard(state.lock);
+    state.requests++;
+    if (status != STATUS_OK) {
+        state.failures++;
+    }
+    return sent;
+}
+
+/**
+ * Worker thread body: serve queued connections one request at a time.
+ *
+ * @param state the server state
+ */
+static void workerLoop(ServerState* state) {
+
+    // Buffers kept from one request to the next.
+    vector<unsigned char> input;
+    vector<unsigned char> output;
+
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> guard(state->lock);
+            state->ready.wait(guard, [&]() { return !state->jobs.empty(); });
+            job = state->jobs.front();
+            state->jobs.pop_front();
+        }
+
+        bool keep = false;
+        try {
+            keep = serveRequest(*state, job.sock, input, output);
+        } catch (const exception& e) {
+            // The peer broke the protocol; drop the connection.
+            keep = false;
+        }
+        double micros = chrono::duration<double, micro>(
+            chrono::steady_clock::now() - job.queued).count();
+
+        lock_guard<mutex> guard(state->lock);
+        if (keep) {
+            if (state->latencies.size() < LATENCY_WINDOW) {
+                state->latencies.push_back(micros);
+            } else {
+                state->latencies[state->nextLatency] = micros;
+            }
+            state->nextLatency = (state->nextLatency + 1) % LATENCY_WINDOW;
+
+            // Back to the main thread, to wait for the next request.
+            state->returned.push_back(job.sock);
+            char wake = 0;
+            if (write(state->wakePipe[1], &wake, 1) < 0) {
+                // The pipe is full, so the main thread is awake anyway.
+            }
+        } else {
+            close(job.sock);
+            state->connections--;
+        }
+    }
+}
+
+/**
+ * Create the listening socket.
+ *
+ * @param path the socket path (replaced if it exists)
+ * @return the socket
+ */
+static int listenOn(const string& path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error("Socket path too long");
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(sock, SOMAXCONN) != 0) {
+        error("Cannot listen on " + path + ": " + strerror(errno));
+    }
+    return sock;
+}
+
+/**
+ * The Main function of the service.
+ *
+ * @param argc the number of program arguments
+ * @param argv the program arguments
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main(int argc, char** argv) {
+    size_t threads = 0;
+    size_t cacheSize = TREE_CACHE_SIZE;
+
+    ServerState state;
+    state.flags = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "j:t:c")) != -1) {
+        switch (option) {
+        case 'j':
+            threads = strtoul(optarg, nullptr, 10);
+            break;
+        case 't':
+            cacheSize = strtoul(optarg, nullptr, 10);
+            break;
+        case 'c':
+            state.flags |= FLAG_CHECKSUM;
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+    if (argc - optind != 1) {
+        error("Incorrect parameters\n");
+        return 1;
+    }
+    string path = argv[optind];
+
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    state.cache = cacheSize > 0 ? new TreeCache(cacheSize) : nullptr;
+    state.options.trees = state.cache;
+    state.connections = 0;
+    state.maxQueueDepth = 0;
+    state.requests = 0;
+    state.failures = 0;
+    state.nextLatency = 0;
+    if (pipe2(state.wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        error("Cannot create pipe");
+    }
+
+    int listenFd = listenOn(path);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (size_t i = 0; i < threads; i++) {
+        thread(workerLoop, &state).detach();
+    }
+
+    // Idle connections, waiting for their next request.
+    vector<int> idle;
+    while (!stopRequested) {
+        vector<pollfd> fds;
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({state.wakePipe[0], POLLIN, 0});
+        for (int sock : idle) {
+            fds.push_back({sock, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            continue;
+        }
+
+        // Queue every connection with a request (or a hangup) waiting.
+        vector<int> stillIdle;
+        {
+            lock_guard<mutex> guard(state.lock);
+            for (size_t i = 2; i < fds.size(); i++) {
+                if (fds[i].revents == 0) {
+                    stillIdle.push_back(fds[i].fd);
+                    continue;
+                }
+                Job job = {fds[i].fd, chrono::steady_clock::now()};
+                state.jobs.push_back(job);
+            }
+            state.maxQueueDepth = max(state.maxQueueDepth, state.jobs.size());
+
+            if (fds[1].revents != 0) {
+                char drain[256];
+                while (read(state.wakePipe[0], drain, sizeof(drain)) > 0) {
+                }
+                stillIdle.insert(stillIdle.end(), state.returned.begin(),
+                                 state.returned.end());
+                state.returned.clear();
+            }
+        }
+        state.ready.notify_all();
+
+        if (fds[0].revents != 0) {
+            int sock = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (sock >= 0) {
+                // The message deadlines are what bound a request; these
+                // only keep any single blocking call from outliving them.
+                timeval timeout = {REQUEST_TIMEOUT_SECONDS, 0};
+                setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                           sizeof(timeout));
+                setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                           sizeof(timeout));
+                stillIdle.push_back(sock);
+                lock_guard<mutex> guard(state.lock);
+                state.connections++;
+            }
+        }
+        idle.swap(stillIdle);
+    }
+
+    // Workers are detached, so leave without waiting for them.
+    unlink(path.c_str());
+    exit(0);
+}
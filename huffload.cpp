@@ -0,0 +1,231 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides huffload, a load generator for the compression
+ * service (huffd). Every client thread opens one connection and sends its
+ * requests back to back, cycling through the given files, and times each
+ * request from sending it to having the whole reply. At the end it prints
+ * the throughput and the median and 99th percentile latency of each
+ * operation, followed by the service's own metrics.
+ *
+ * Usage: huffload [-c clients] [-n requests] [-m] [-d] socket file...
+ *   -c  number of concurrent clients (default 4)
+ *   -n  number of compress requests per client (default 1000)
+ *   -m  pass buffers as memfds instead of through the socket
+ *   -d  also decompress every reply and check the round trip
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Codec.hpp"
+#include "Helper.hpp"
+#include "MappedFile.hpp"
+#include "Service.hpp"
+
+/**
+ * Latencies of one client, in microseconds.
+ */
+struct ClientResult {
+    vector<double> compress;
+    vector<double> decompress;
+    uint64_t bytes;
+    bool failed;
+};
+
+/**
+ * Send a request and wait for its reply.
+ *
+ * @param sock the connection
+ * @param op the operation
+ * @param data the request data
+ * @param size its size
+ * @param useFd true to pass the data in a memfd
+ * @param reply set to the reply data
+ */
+static void request(int sock, unsigned char op, const unsigned char* data,
+                    size_t size, bool useFd, vector<unsigned char>& reply) {
+    if (!sendMessage(sock, op, data, size, useFd)) {
+        error("Service closed the connection");
+    }
+    ServiceMessage msg;
+    if (!receiveMessage(sock, msg, reply)) {
+        error("Service closed the connection");
+    }
+    FdGuard passed(msg.fd);
+    if (msg.fd >= 0) {
+        MappedFile* shared = mapSharedBuffer(msg);
+        reply.assign(shared->data(), shared->data() + shared->size());
+        delete(shared);
+    }
+    if (msg.code != STATUS_OK) {
+        error("Service error: " + string(reply.begin(), reply.end()));
+    }
+}
+
+/**
+ * Client thread body.
+ *
+ * @param path the socket path
+ * @param files the inputs
+ * @param id the number of this client
+ * @param count how many compress requests to send
+ * @param useFd true to pass buffers as memfds
+ * @param roundTrip true to decompress every reply too
+ * @param result where to store the latencies
+ */
+static void runClient(const string& path,
+                      const vector<vector<unsigned char> >* files, int id,
+                      size_t count, bool useFd, bool roundTrip,
+                      ClientResult* result) {
+    result->bytes = 0;
+    result->failed = false;
+    try {
+        int sock = connectService(path);
+        vector<unsigned char> compressed;
+        vector<unsigned char> decompressed;
+
+        for (size_t i = 0; i < count; i++) {
+            const vector<unsigned char>& file = (*files)[(id + i) %
+                                                         files->size()];
+
+            auto start = chrono::steady_clock::now();
+            request(sock, OP_COMPRESS, file.data(), file.size(), useFd,
+                    compressed);
+            auto end = chrono::steady_clock::now();
+            result->compress.push_back(
+                chrono::duration<double, micro>(end - start).count());
+            result->bytes += file.size();
+
+            if (roundTrip) {
+                start = chrono::steady_clock::now();
+                request(sock, OP_DECOMPRESS, compressed.data(),
+                        compressed.size(), useFd, decompressed);
+                end = chrono::steady_clock::now();
+                result->decompress.push_back(
+                    chrono::duration<double, micro>(end - start).count());
+                if (decompressed != file) {
+                    error("Round trip mismatch");
+                }
+            }
+        }
+        close(sock);
+    } catch (const exception& e) {
+        fprintf(stderr, "client %d: %s\n", id, e.what());
+        result->failed = true;
+    }
+}
+
+/**
+ * Print the percentiles of a set of latencies.
+ *
+ * @param name the operation
+ * @param latencies the latencies, in microseconds
+ */
+static void printLatencies(const char* name, vector<double> latencies) {
+    if (latencies.empty()) {
+        return;
+    }
+    sort(latencies.begin(), latencies.end());
+    size_t last = latencies.size() - 1;
+    printf("%-12s %8zu requests  p50 %10.1f us  p99 %10.1f us  "
+           "max %10.1f us\n", name, latencies.size(),
+           latencies[(size_t)(0.50 * last + 0.5)],
+           latencies[(size_t)(0.99 * last + 0.5)], latencies[last]);
+}
+
+/**
+ * The Main function of the load generator.
+ *
+ * @param argc the number of program arguments
+ * @param argv the program arguments
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main(int argc, char** argv) {
+    size_t clients = 4;
+    size_t count = 1000;
+    bool useFd = false;
+    bool roundTrip = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "c:n:md")) != -1) {
+        switch (option) {
+        case 'c':
+            clients = max(1ul, strtoul(optarg, nullptr, 10));
+            break;
+        case 'n':
+            count = strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            useFd = true;
+            break;
+        case 'd':
+            roundTrip = true;
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+    if (argc - optind < 2) {
+        error("Incorrect parameters\n");
+        return 1;
+    }
+    string path = argv[optind];
+
+    vector<vector<unsigned char> > files(argc - optind - 1);
+    for (size_t i = 0; i < files.size(); i++) {
+        readWholeFile(argv[optind + 1 + i], files[i]);
+    }
+
+    vector<ClientResult> results(clients);
+    vector<thread> threads;
+    auto start = chrono::steady_clock::now();
+    for (size_t c = 0; c < clients; c++) {
+        threads.push_back(thread(runClient, path, &files, (int)c, count,
+                                 useFd, roundTrip, &results[c]));
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    double seconds = chrono::duration<double>(
+        chrono::steady_clock::now() - start).count();
+
+    vector<double> compress;
+    vector<double> decompress;
+    uint64_t bytes = 0;
+    bool failed = false;
+    for (const ClientResult& result : results) {
+        compress.insert(compress.end(), result.compress.begin(),
+                        result.compress.end());
+        decompress.insert(decompress.end(), result.decompress.begin(),
+                          result.decompress.end());
+        bytes += result.bytes;
+        failed |= result.failed;
+    }
+
+    printf("%zu clients, %.2f s, %.1f MB/s compressed\n", clients, seconds,
+           bytes / seconds / 1e6);
+    printLatencies("compress", compress);
+    printLatencies("decompress", decompress);
+
+    // The service's view of the same run.
+    int sock = connectService(path);
+    vector<unsigned char> stats;
+    request(sock, OP_STATS, nullptr, 0, false, stats);
+    close(sock);
+    printf("\n%s", string(stats.begin(), stats.end()).c_str());
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,351 @@
+/*
+ * Name: Hariz Megat Zariman
+ * Email: mqmegatz@ucsd.edu
+ *
+ * Sources Used: None.
+ *
+ * This file provides transcode, which migrates a file from the
+ * single-stream format (totalFrequency, serialization, encodings) to the
+ * block format with a block index (see BlockFormat.hpp), without writing
+ * the decoded bytes anywhere. The bitstream is decoded a batch of blocks
+ * at a time; while the workers of a thread pool code one batch into
+ * blocks, the next batch is being decoded, so the sequential decoder and
+ * the parallel encoder overlap. Coded blocks are written in order through
+ * the pipeline's writer stage, and the index of where every block landed
+ * goes after the end block.
+ *
+ * At the end the throughput of each stage and of the whole run is
+ * printed to stderr, along with how long a petabyte of single-stream
+ * files would take at that rate when the run was large enough to say.
+ *
+ * Usage: transcode [-j threads] [-c] [-o] [-e coder] infile outfile
+ *   -j  number of encoding threads (default: one per CPU)
+ *   -c  protect every block with a CRC32C checksum
+ *   -o  try order-1 context trees on every block
+ *   -e  entropy coder: huffman (default), ans, or auto
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "BlockFormat.hpp"
+#include "HCTree.hpp"
+#include "Helper.hpp"
+#include "Pipeline.hpp"
+#include "ThreadPool.hpp"
+
+// Raw size of the blocks written (the same as compress).
+static const size_t TRANSCODE_BLOCK_SIZE = 1 << 20;
+
+// Blocks every worker codes per batch.
+static const size_t BLOCKS_PER_WORKER = 2;
+
+// Bytes in a petabyte, for the projection.
+static const double PETABYTE = 1e15;
+
+// Below both of these a run is dominated by start-up costs, and its rate
+// says little about a petabyte.
+static const uint64_t PROJECTION_MIN_BYTES = 64 << 20;
+static const double PROJECTION_MIN_SECONDS = 1.0;
+
+/**
+ * What a run did and how long it took.
+ */
+struct TranscodeStats {
+    uint64_t legacyBytes; // size of the input
+    uint64_t rawBytes;    // size of the decoded data
+    uint64_t outputBytes; // size of the output
+    size_t blocks;
+    size_t threads;       // encoding threads
+    double decodeSeconds; // time spent decoding
+    double encodeSeconds; // time spent coding blocks
+    double seconds;       // the whole run
+};
+
+/**
+ * Decoded bytes waiting to be coded.
+ */
+struct Batch {
+    vector<unsigned char> data;
+    size_t size;
+};
+
+/**
+ * @param start when the interval began
+ * @return the seconds since then
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+        .count();
+}
+
+/**
+ * Pass the coded bytes collected so far to the writer stage.
+ *
+ * @param pipe the pipeline
+ * @param encoded the coded bytes (emptied)
+ * @param written the number of bytes passed on so far (updated)
+ */
+static void emitEncoded(BlockPipeline& pipe, vector<unsigned char>& encoded,
+                        uint64_t& written) {
+    Block* block = pipe.acquireOutput();
+    swap(block->data, encoded);
+    block->size = block->data.size();
+    encoded.clear();
+    written += block->size;
+    pipe.emitOutput(block);
+}
+
+/**
+ * Transcode a single-stream file to an indexed block format file.
+ *
+ * @param inputFd the input file
+ * @param outputFd the output file
+ * @param treeLimit bound on the size of the serialized tree
+ * @param flags the file header flags (FLAG_INDEX is added)
+ * @param options how to code each block
+ * @param stats set to what the run did
+ */
+static void transcode(int inputFd, int outputFd, int treeLimit,
+                      unsigned char flags, const EncodeOptions& options,
+                      TranscodeStats& stats) {
+    auto start = chrono::steady_clock::now();
+    ThreadPool pool(stats.threads);
+    stats.threads = pool.size();
+
+    BlockPipeline transcodePass(inputFd, outputFd);
+    transcodePass.run([&](BlockPipeline& pipe) {
+        BitReader bits(nullptr, 0, &pipe);
+
+        // An empty input has no header at all.
+        int totalFreq = bits.read<int>();
+        HCTree tree;
+        if (!bits.good()) {
+            totalFreq = 0;
+        } else if (totalFreq < 0) {
+            // Block and adaptive files start with a negative magic number.
+            error("Not a single-stream file");
+        } else {
+            tree.deserialize(treeLimit, bits);
+        }
+
+        FileHeader header;
+        header.version = BLOCK_VERSION;
+        header.flags = flags | FLAG_INDEX;
+        header.blockSize = TRANSCODE_BLOCK_SIZE;
+        header.totalSize = totalFreq;
+
+        vector<unsigned char> encoded;
+        uint64_t written = 0;
+        writeFileHeader(header, encoded);
+
+        // Two batches: one being coded while the other is being decoded.
+        size_t batchBlocks = pool.size() * BLOCKS_PER_WORKER;
+        Batch batches[2];
+        for (Batch& batch : batches) {
+            batch.data.resize(batchBlocks * TRANSCODE_BLOCK_SIZE);
+            batch.size = 0;
+        }
+        vector<vector<unsigned char> > coded(batchBlocks);
+
+        uint64_t remaining = totalFreq;
+        auto decodeBatch = [&](Batch& batch) {
+            auto decodeStart = chrono::steady_clock::now();
+            batch.size = min<uint64_t>(remaining, batch.data.size());
+            tree.decodeBlock(bits, batch.data.data(), batch.size);
+            if (batch.size > 0 && !bits.good()) {
+                error("Truncated input");
+            }
+            remaining -= batch.size;
+            stats.decodeSeconds += secondsSince(decodeStart);
+        };
+
+        vector<BlockIndexEntry> index;
+        uint64_t rawOffset = 0;
+        decodeBatch(batches[0]);
+        for (int current = 0; batches[current].size > 0;
+             current = 1 - current) {
+            Batch& batch = batches[current];
+            size_t count = (batch.size + TRANSCODE_BLOCK_SIZE - 1) /
+                           TRANSCODE_BLOCK_SIZE;
+
+            // Decode the next batch while the workers code this one.
+            string failure;
+            thread decoder([&]() {
+                try {
+                    decodeBatch(batches[1 - current]);
+                } catch (const exception& e) {
+                    failure = e.what();
+                }
+            });
+
+            auto encodeStart = chrono::steady_clock::now();
+            try {
+                pool.run(count, [&](int, size_t i) {
+                    size_t offset = i * TRANSCODE_BLOCK_SIZE;
+                    coded[i].clear();
+                    encodeBlock(batch.data.data() + offset,
+                                min(TRANSCODE_BLOCK_SIZE,
+                                    batch.size - offset),
+                                header, coded[i], options);
+                });
+            } catch (...) {
+                decoder.join();
+                throw;
+            }
+            stats.encodeSeconds += secondsSince(encodeStart);
+            decoder.join();
+            if (!failure.empty()) {
+                error(failure);
+            }
+
+            // Append the blocks in order, noting where each one starts.
+            for (size_t i = 0; i < count; i++) {
+                BlockIndexEntry entry = {written + encoded.size(),
+                                         rawOffset};
+                index.push_back(entry);
+                rawOffset += min(TRANSCODE_BLOCK_SIZE,
+                                 batch.size - i * TRANSCODE_BLOCK_SIZE);
+                encoded.insert(encoded.end(), coded[i].begin(),
+                               coded[i].end());
+                if (encoded.size() >= pipe.blockSize()) {
+                    emitEncoded(pipe, encoded, written);
+                }
+            }
+        }
+
+        writeEndBlock(header, encoded);
+        writeBlockIndex(index, written + encoded.size(), encoded);
+        emitEncoded(pipe, encoded, written);
+
+        stats.legacyBytes = bits.good() ? (bits.position() + 7) / 8 : 0;
+        stats.rawBytes = rawOffset;
+        stats.outputBytes = written;
+        stats.blocks = index.size();
+    });
+
+    stats.seconds = secondsSince(start);
+}
+
+/**
+ * Print the throughput of a run, and what it means for a migration.
+ *
+ * @param stats what the run did
+ */
+static void reportThroughput(const TranscodeStats& stats) {
+    double seconds = max(stats.seconds, 1e-9);
+    double legacyRate = stats.legacyBytes / seconds;
+
+    fprintf(stderr, "%llu bytes -> %llu bytes (%llu decoded, %zu blocks) "
+            "in %.2f s\n", (unsigned long long)stats.legacyBytes,
+            (unsigned long long)stats.outputBytes,
+            (unsigned long long)stats.rawBytes, stats.blocks, seconds);
+    fprintf(stderr, "decode %.1f MB/s (1 thread), encode %.1f MB/s "
+            "(%zu %s), overall %.1f MB/s decoded\n",
+            stats.rawBytes / max(stats.decodeSeconds, 1e-9) / 1e6,
+            stats.rawBytes / max(stats.encodeSeconds, 1e-9) / 1e6,
+            stats.threads, stats.threads == 1 ? "thread" : "threads",
+            stats.rawBytes / seconds / 1e6);
+
+    if (stats.blocks == 0) {
+        return;
+    }
+    if (stats.rawBytes < PROJECTION_MIN_BYTES &&
+        stats.seconds < PROJECTION_MIN_SECONDS) {
+        fprintf(stderr, "run too small to project to 1 PB (needs %llu MiB "
+                "decoded or %.0f s)\n",
+                (unsigned long long)(PROJECTION_MIN_BYTES >> 20),
+                PROJECTION_MIN_SECONDS);
+        return;
+    }
+
+    // The archive is measured in the files it holds now, so the projection
+    // goes by the input rate.
+    double days = PETABYTE / legacyRate / 86400;
+    fprintf(stderr, "1 PB of single-stream files at %.1f MB/s: "
+            "%.1f machine-days (%s-bound)\n", legacyRate / 1e6, days,
+            stats.decodeSeconds > stats.encodeSeconds ? "decode" : "encode");
+}
+
+/**
+ * The Main function of the transcoder.
+ *
+ * @param argc the number of program arguments
+ * @param argv the program arguments
+ * @return 0 if program successful, otherwise stderr.
+ */
+int main(int argc, char** argv) {
+    unsigned char flags = 0;
+    EncodeOptions options;
+    TranscodeStats stats = {0, 0, 0, 0, 0, 0, 0, 0};
+
+    int option;
+    while ((option = getopt(argc, argv, "j:coe:")) != -1) {
+        switch (option) {
+        case 'j':
+            stats.threads = strtoul(optarg, nullptr, 10);
+            break;
+        case 'c':
+            flags |= FLAG_CHECKSUM;
+            break;
+        case 'o':
+            options.order1 = true;
+            break;
+        case 'e':
+            if (string(optarg) == "huffman") {
+                options.coder = CODER_HUFFMAN;
+            } else if (string(optarg) == "ans") {
+                options.coder = CODER_ANS;
+            } else if (string(optarg) == "auto") {
+                options.coder = CODER_AUTO;
+            } else {
+                error("Unknown coder " + string(optarg) + "\n");
+                return 1;
+            }
+            break;
+        default:
+            error("Incorrect parameters\n");
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        error("Incorrect parameters\n");
+        return 1;
+    }
+
+    int inputFd = open(argv[optind], O_RDONLY);
+    if (inputFd < 0) {
+        error("Cannot open input file\n");
+        return 1;
+    }
+    int outputFd = open(argv[optind + 1], O_WRONLY | O_CREAT | O_TRUNC,
+                        0644);
+    if (outputFd < 0) {
+        error("Cannot open output file\n");
+        return 1;
+    }
+
+    // The serialized tree can not be larger than the input.
+    struct stat inputStat;
+    long inputSize = LONG_MAX;
+    if (fstat(inputFd, &inputStat) == 0 && S_ISREG(inputStat.st_mode)) {
+        inputSize = inputStat.st_size;
+    }
+    int treeLimit = (int)min<long>(inputSize - (long)sizeof(int), INT_MAX);
+
+    transcode(inputFd, outputFd, treeLimit, flags, options, stats);
+    close(inputFd);
+    close(outputFd);
+
+    reportThroughput(stats);
+    return 0;
+}